@@ -5,8 +5,30 @@
 #include <vector>    // Librería para usar vectores
 #include <chrono>    // Librería para manipular tiempo
 #include <mutex>     // Librería para usar mutex (para evitar condiciones de carrera)
+#include <condition_variable> // Librería para esperar con cancelación (condition_variable_any)
+#include <stop_token> // Librería para cancelar hilos (stop_token, jthread)
 #include <fstream>   // Librería para manejar archivos
 #include <sstream>   // Librería para construir cadenas de texto
+#include <atomic>    // Librería para operaciones atómicas (cola sin bloqueo)
+#include <memory>    // Librería para punteros inteligentes
+#include <new>       // Librería para construir objetos en memoria ya reservada (launder)
+#include <optional>  // Librería para valores opcionales (resultado de consumir)
+#include <deque>     // Librería para colas de doble extremo (almacenamiento del modo Semaforo)
+#include <string>    // Librería para manejar cadenas de texto
+#include <string_view> // Librería para pasar mensajes sin copiarlos
+#include <cstring>   // Librería para copiar memoria (memcpy)
+#include <algorithm> // Librería para algoritmos (min, max)
+#include <random>    // Librería para generar números aleatorios (llegadas de Poisson)
+#include <cstdlib>   // Librería para convertir texto a números (strtod)
+#include <array>     // Librería para arreglos de tamaño fijo
+#include <bit>       // Librería para operaciones de bits (countl_zero)
+#include <span>      // Librería para vistas de arreglos (lotes de ítems)
+#include <utility>   // Librería para intercambiar valores (exchange)
+#include <type_traits> // Librería para consultar propiedades de tipos (is_trivially_copyable)
+#include <functional> // Librería para guardar tareas de tipos distintos (function)
+#include <coroutine> // Librería para corrutinas (co_await)
+#include <tuple>     // Librería para tuplas (temporizadores de la simulación)
+#include "buffer.h"   // Buffer compartido con el benchmark (incluye eventos.h)
 
 using namespace std;
 
@@ -14,101 +36,759 @@ using namespace std;
 int N;    // Número de ítems que produce cada productor y consume cada consumidor
 int NP;   // Número de productores
 int NC;   // Número de consumidores
-const int MAX_WAIT_TIME_MS = 5000;  // Tiempo máximo de espera para consumidores (en milisegundos)
-const int PRODUCER_RETRY_DELAY_MS = 500;  // Tiempo de espera para que un productor vuelva a intentar insertar si el buffer está lleno
-
-// Archivo de salida para guardar los datos
-ofstream logFile("producer-consumer.txt");  
-std::mutex print_mutex;  // Mutex para sincronizar impresiones y evitar conflictos
-
-// Función para imprimir y escribir en archivo 
-void printMessage(const std::string& message) {
-    std::lock_guard<std::mutex> lock(print_mutex);  // Bloquear el mutex para asegurar exclusividad en las impresiones
-    cout << message;  // Imprimir en la consola
-    logFile << message;  // Escribir en el archivo
+int BATCH_SIZE = 1;  // Ítems por lote de productores y consumidores (--lote=<K>)
+int STEAL_BATCH = 0;  // Ítems que cada consumidor pasa a su deque local con --robo=<K>; 0 desactiva el robo
+bool USE_EXECUTOR = false;  // Ejecuta productores y consumidores como tareas de un ejecutor (--ejecutor)
+bool USE_COROUTINES = false;  // Ejecuta productores y consumidores como corrutinas (--corrutinas)
+unsigned EXECUTOR_THREADS = 0;  // Hilos del ejecutor o del planificador de corrutinas (=<H>); 0 usa la concurrencia del hardware
+int LANES = 0;  // Carriles del modo Carriles (--carriles=<L>); 0 significa uno por productor
+bool SIMULATE = false;  // Ejecuta productores y consumidores sobre un reloj virtual (--simulacion)
+uint64_t RANDOM_SEED = 0;  // Semilla que se combina con la de cada carga (--simulacion=<semilla>)
+
+// Modelo de carga que un productor o consumidor aplica después de cada ítem
+class Workload {
+public:
+    // Tipos de carga disponibles
+    enum class Kind {
+        Cero,     // Sin espera entre ítems
+        Fijo,     // Espera fija de `milliseconds`
+        Poisson,  // Esperas exponenciales de media `milliseconds` (llegadas de Poisson)
+        Rafaga,   // Ráfagas de `burst_items` ítems seguidos y luego una pausa de `milliseconds`
+        CPU       // Trabajo de cómputo sintético de `iterations` iteraciones, sin dormir
+    };
+
+private:
+    Kind kind = Kind::Cero;
+    double milliseconds = 0;  // Espera fija, media de Poisson o pausa entre ráfagas
+    int burst_items = 1;      // Ítems por ráfaga
+    long iterations = 0;      // Iteraciones del trabajo sintético
+    int burst_count = 0;      // Ítems emitidos en la ráfaga actual
+    mt19937_64 random;        // Generador propio de cada hilo
+
+    // Convierte un número de la especificación; falla si sobra texto o es negativo
+    static bool parseNumber(const string& text, double& value) {
+        char* end = nullptr;
+        value = strtod(text.c_str(), &end);
+        return !text.empty() && *end == '\0' && value >= 0;
+    }
+
+public:
+    Workload() = default;
+    Workload(Kind kind, double milliseconds) : kind(kind), milliseconds(milliseconds) {}
+
+    // Interpreta "cero", "fijo:<ms>", "poisson:<ms>", "rafaga:<ítems>,<ms>" o "cpu:<iteraciones>"
+    static bool parse(const string& spec, Workload& workload) {
+        size_t colon = spec.find(':');
+        string name = spec.substr(0, colon);
+        string args = colon == string::npos ? "" : spec.substr(colon + 1);
+        double value;
+        if (name == "cero" && colon == string::npos) {
+            workload = Workload(Kind::Cero, 0);
+        } else if ((name == "fijo" || name == "poisson") && parseNumber(args, value)) {
+            workload = Workload(name == "fijo" ? Kind::Fijo : Kind::Poisson, value);
+        } else if (name == "rafaga") {
+            size_t comma = args.find(',');
+            double items, pause;
+            if (comma == string::npos || !parseNumber(args.substr(0, comma), items) ||
+                !parseNumber(args.substr(comma + 1), pause) || items < 1) {
+                return false;
+            }
+            workload = Workload(Kind::Rafaga, pause);
+            workload.burst_items = static_cast<int>(items);
+        } else if (name == "cpu" && parseNumber(args, value)) {
+            workload = Workload(Kind::CPU, 0);
+            workload.iterations = static_cast<long>(value);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Prepara el generador aleatorio del hilo que usará esta carga
+    void seed(uint64_t value) {
+        random.seed(value + RANDOM_SEED * 0x9E3779B97F4A7C15ull);  // Con RANDOM_SEED en 0, la semilla es `value`
+        burst_count = 0;
+    }
+
+    // Aplica la carga correspondiente a un ítem en el hilo actual
+    void apply() {
+        chrono::nanoseconds pause = next();
+        if (pause > chrono::nanoseconds::zero()) {
+            this_thread::sleep_for(pause);
+        }
+    }
+
+    // Calcula la carga de un ítem: hace el trabajo de cómputo y retorna la pausa que corresponde,
+    // sin dormirla (el ejecutor la convierte en un temporizador)
+    chrono::nanoseconds next() {
+        auto pause = [](double ms) {
+            return chrono::duration_cast<chrono::nanoseconds>(chrono::duration<double, milli>(ms));
+        };
+        switch (kind) {
+        case Kind::Cero:
+            break;
+        case Kind::Fijo:
+            return pause(milliseconds);
+        case Kind::Poisson: {
+            exponential_distribution<double> gap(1.0 / max(milliseconds, 1e-9));  // Tiempo entre llegadas
+            return pause(gap(random));
+        }
+        case Kind::Rafaga:
+            if (++burst_count >= burst_items) {  // Fin de la ráfaga: pausa
+                burst_count = 0;
+                return pause(milliseconds);
+            }
+            break;
+        case Kind::CPU: {
+            uint64_t x = 88172645463325252ull;  // Estado de xorshift para que el compilador no elimine el bucle
+            for (long i = 0; i < iterations; ++i) {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+            }
+            static atomic<uint64_t> sink{0};
+            sink.fetch_xor(x, memory_order_relaxed);
+            break;
+        }
+        }
+        return chrono::nanoseconds::zero();
+    }
+};
+
+Workload PRODUCER_WORKLOAD(Workload::Kind::Fijo, 2000);  // Carga de los productores (--carga-productor)
+Workload CONSUMER_WORKLOAD(Workload::Kind::Fijo, 1500);  // Carga de los consumidores (--carga-consumidor)
+
+// Etapa intermedia del pipeline: un grupo de trabajadores que toma ítems del buffer de la etapa
+// anterior (o de los productores), les aplica su carga y los pasa al buffer de la siguiente etapa
+// (o de los consumidores)
+struct StageConfig {
+    string name;        // Nombre de la etapa (solo para los mensajes)
+    int workers;        // Cantidad de trabajadores de la etapa
+    Workload workload;  // Carga aplicada a cada ítem
+};
+vector<StageConfig> STAGES;  // Etapas entre productores y consumidores, en orden (--etapa y --etapas)
+
+// Interpreta "nombre:trabajadores[:carga]"; sin carga la etapa solo reenvía los ítems
+bool parseStage(const string& spec, StageConfig& stage) {
+    size_t first = spec.find(':');
+    if (first == string::npos || first == 0) {
+        return false;
+    }
+    size_t second = spec.find(':', first + 1);
+    string workers = spec.substr(first + 1, second == string::npos ? string::npos : second - first - 1);
+    char* end = nullptr;
+    long count = strtol(workers.c_str(), &end, 10);
+    if (workers.empty() || *end != '\0' || count < 1) {
+        return false;
+    }
+    stage.name = spec.substr(0, first);
+    stage.workers = static_cast<int>(count);
+    stage.workload = Workload(Workload::Kind::Cero, 0);
+    return second == string::npos || Workload::parse(spec.substr(second + 1), stage.workload);
+}
+
+// Agrega a STAGES las etapas de un archivo, una por línea con el formato de parseStage (las líneas
+// vacías y las que empiezan con # se ignoran). Retorna false si el archivo no se pudo leer o
+// alguna línea no es válida (y la informa en `error`)
+bool loadStages(const string& path, string& error) {
+    ifstream file(path);
+    if (!file) {
+        error = "No se pudo abrir el archivo de etapas: " + path;
+        return false;
+    }
+    string line;
+    while (getline(file, line)) {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        StageConfig stage;
+        if (!parseStage(line, stage)) {
+            error = "Etapa no válida en " + path + ": " + line;
+            return false;
+        }
+        STAGES.push_back(stage);
+    }
+    return true;
 }
 
-class Buffer {
+// Resultado de ejecutar un paso de una tarea en el ejecutor
+struct TaskStep {
+    enum class Kind {
+        Listo,      // Avanzó y puede seguir de inmediato
+        Bloqueado,  // No pudo avanzar porque el buffer estaba lleno o vacío
+        Pausa,      // Avanzó y no debe seguir hasta que pase `pause`
+        Terminado   // La tarea terminó
+    };
+    Kind kind;
+    chrono::nanoseconds pause{};  // Solo para Pausa (el ejecutor la mide en tiempo real o virtual)
+
+    // Paso que avanzó y debe esperar `pause` (la pausa de la carga) antes de seguir
+    static TaskStep after(chrono::nanoseconds pause) {
+        if (pause <= chrono::nanoseconds::zero()) {
+            return {Kind::Listo};
+        }
+        return {Kind::Pausa, pause};
+    }
+};
+
+// Espera de una tarea que cede su hilo mientras el buffer está lleno o vacío: se cuenta una vez por
+// ítem en las métricas de la tarea y dura desde el primer paso bloqueado hasta el siguiente que avanza
+class TaskWait {
 private:
-    queue<int> buffer;  // Cola que representa el buffer compartido
-    counting_semaphore<1> buffer_mutex{1};   // Semáforo para sincronizar el acceso al buffer
-    counting_semaphore<> spaces;       // Semáforo que indica los espacios disponibles en el buffer
-    counting_semaphore<> items{0};     // Semáforo que indica cuántos ítems hay en el buffer para consumir
+    bool waiting = false;  // Indica que la tarea está esperando
+    uint64_t start_ns = 0; // Inicio de la espera
 
 public:
-    // Constructor que inicializa el semáforo `spaces` con la capacidad del buffer
-    Buffer(int capacity) : spaces(capacity) {}  
+    bool active() const {
+        return waiting;
+    }
+
+    void begin(ThreadMetrics& metrics) {
+        if (!waiting) {
+            waiting = true;
+            start_ns = elapsedNanoseconds();
+            metrics.waits++;
+        }
+    }
+
+    void end(ThreadMetrics& metrics) {
+        if (waiting) {
+            waiting = false;
+            metrics.blocked_ns += elapsedNanoseconds() - start_ns;
+        }
+    }
+};
+
+// Lado del buffer en que trabaja una tarea del ejecutor
+enum class TaskRole {
+    Productor,  // Inserta: la destraba un espacio libre
+    Consumidor  // Consume: la destraba un ítem nuevo o el cierre del buffer
+};
+
+// Ejecutor con una cantidad fija de hilos sobre los que se reparten muchas tareas.
+// Cada tarea avanza de a un paso y retorna cuándo puede seguir; una tarea bloqueada en el buffer
+// cede su hilo y queda estacionada hasta que una tarea del otro lado avance (un productor espera
+// que un consumidor libere espacio y un consumidor, que un productor inserte), y las pausas de la
+// carga se convierten en temporizadores, de modo que miles de productores y consumidores no
+// necesitan miles de hilos ni ocupan el procesador mientras esperan.
+// Las mismas tareas se pueden ejecutar en un solo hilo sobre un reloj virtual (simulate()).
+class Executor {
+private:
+    using Clock = chrono::steady_clock;
+    using Timer = pair<Clock::time_point, size_t>;  // Momento de reanudación e índice de la tarea
 
-    // Método para manejar el caso cuando el productor está esperando para insertar el ítem
-    void notifyProducerWait(int id, int item) {
-        std::lock_guard<std::mutex> lock(print_mutex);  // Bloquear el mutex para que la impresión sea atómica
-        cout << "Error de inserción - buffer lleno. El productor " << id << " está esperando para insertar el ítem " << item << endl;
-        logFile << "Error de inserción - buffer lleno. El productor " << id << " está esperando para insertar el ítem " << item << endl; // Escribir en el archivo
+    vector<function<TaskStep()>> tasks;  // Tareas registradas
+    mutex queue_mutex;                   // Protege las colas y el contador de tareas pendientes
+    condition_variable changed;          // Avisa que hay tareas listas o que todas terminaron
+    deque<size_t> ready;                 // Tareas que pueden ejecutar su próximo paso
+    priority_queue<Timer, vector<Timer>, greater<Timer>> sleeping;  // Tareas en pausa, la más próxima primero
+    vector<TaskRole> roles;              // Lado del buffer de cada tarea
+    deque<size_t> waiting_space;         // Productores estacionados con el buffer lleno
+    deque<size_t> waiting_items;         // Consumidores estacionados con el buffer vacío
+    uint64_t producer_steps = 0;         // Pasos de productores que avanzaron (detecta avances durante un paso bloqueado)
+    uint64_t consumer_steps = 0;         // Pasos de consumidores que avanzaron
+    size_t remaining = 0;                // Tareas que aún no terminan
+
+public:
+    // Registra una tarea con su lado del buffer; debe llamarse antes de run()
+    void add(function<TaskStep()> task, TaskRole role) {
+        tasks.push_back(std::move(task));
+        roles.push_back(role);
     }
 
-    // Método para manejar el caso cuando el consumidor espera demasiado tiempo
-    void handleConsumerTimeout(int id) {
-        std::lock_guard<std::mutex> lock(print_mutex);  // Bloquear el mutex para que la impresión sea atómica
-        cout << "Error del consumidor " << id << ": Buffer vacío, el consumidor esperó demasiado tiempo." << endl;  // Mensaje de error
-        logFile << "Error del consumidor " << id << ": Buffer vacío, el consumidor esperó demasiado tiempo." << endl;  // Escribir en el archivo
+    // Ejecuta todas las tareas con `threads` hilos y retorna cuando terminaron todas
+    void run(unsigned threads) {
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            ready.push_back(i);
+        }
+        remaining = tasks.size();
+        vector<thread> workers;
+        for (unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back([this] { work(); });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
     }
 
-    // Método para que un productor añada un ítem al buffer
-    void produce(int id, int item) {
-        while (true) { // Bucle infinito hasta que se produzca la inserción
-            // Intenta adquirir un espacio en el buffer con un tiempo de espera
-            if (!spaces.try_acquire_for(chrono::milliseconds(PRODUCER_RETRY_DELAY_MS))) {
-                notifyProducerWait(id, item);  // Llama al método para manejar la espera del productor
+    // Ejecuta todas las tareas en el hilo actual sobre el reloj virtual (simulación de eventos
+    // discretos): las pausas no duermen, sino que adelantan el reloj hasta el próximo temporizador, y
+    // una tarea bloqueada vuelve a intentarlo cuando otra tarea avanza. Con las mismas tareas y
+    // semillas el orden de los pasos, y por lo tanto el de los eventos, es siempre el mismo.
+    // El reloj virtual queda activo al terminar. Retorna false si las tareas pendientes quedaron
+    // todas bloqueadas sin nada que pueda liberarlas
+    bool simulate() {
+        using VirtualTimer = tuple<uint64_t, uint64_t, size_t>;  // Momento virtual, orden de llegada e índice de la tarea
+        priority_queue<VirtualTimer, vector<VirtualTimer>, greater<VirtualTimer>> timers;  // Tareas en pausa
+        deque<size_t> blocked;  // Tareas que esperan que otra avance
+        uint64_t arrivals = 0;  // Desempata temporizadores del mismo instante por orden de llegada
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            ready.push_back(i);
+        }
+        remaining = tasks.size();
+        VIRTUAL_TIME = true;
+        VIRTUAL_NOW_NS = 0;
+        while (remaining > 0) {
+            if (ready.empty()) {
+                if (timers.empty()) {
+                    return false;  // Solo quedan tareas bloqueadas
+                }
+                VIRTUAL_NOW_NS = get<0>(timers.top());  // Adelantar el reloj hasta el próximo temporizador
+                while (!timers.empty() && get<0>(timers.top()) == VIRTUAL_NOW_NS) {
+                    ready.push_back(get<2>(timers.top()));
+                    timers.pop();
+                }
+            }
+            size_t index = ready.front();
+            ready.pop_front();
+            TaskStep step = tasks[index]();
+            if (step.kind == TaskStep::Kind::Bloqueado) {
+                blocked.push_back(index);
+                continue;
+            }
+            ready.insert(ready.end(), blocked.begin(), blocked.end());  // La tarea avanzó: las bloqueadas reintentan
+            blocked.clear();
+            if (step.kind == TaskStep::Kind::Listo) {
+                ready.push_back(index);
+            } else if (step.kind == TaskStep::Kind::Pausa) {
+                timers.emplace(VIRTUAL_NOW_NS + step.pause.count(), arrivals++, index);
             } else {
-                buffer_mutex.acquire(); // Adquiere el semáforo para acceder al buffer
-                buffer.push(item); // Inserta el ítem en el buffer
-                std::stringstream ss;  // Crear un stringstream para construir el mensaje
-                ss << "Inserción exitosa" << endl;  // Mensaje de inserción exitosa
-                ss << "Productor " << id << " produjo: " << item << "\n"; // Mensaje del productor
-                printMessage(ss.str()); // Llama a la función para imprimir y escribir en el archivo
-                buffer_mutex.release(); // Libera el semáforo después de modificar el buffer
-                items.release(); // Indica que hay un nuevo ítem disponible
-                break; // Sale del bucle después de la inserción
+                --remaining;
             }
         }
+        return true;
     }
 
-    // Método para que un consumidor tome un ítem del buffer
-    int consume(int id) {
-        // Intenta adquirir un ítem con un tiempo de espera
-        if (!items.try_acquire_for(chrono::milliseconds(MAX_WAIT_TIME_MS))) {
-            handleConsumerTimeout(id);  // Llama al método para manejar el timeout del consumidor
-            return -1; // Retorna -1 si no pudo consumir
+private:
+    // Devuelve a la cola de listas la tarea que espera hace más tiempo en `waiting`, si hay alguna
+    void wakeOne(deque<size_t>& waiting) {
+        if (!waiting.empty()) {
+            ready.push_back(waiting.front());
+            waiting.pop_front();
+            changed.notify_one();
         }
+    }
 
-        buffer_mutex.acquire(); // Adquiere el semáforo para acceder al buffer
-        int item = buffer.front(); // Obtiene el ítem en la parte frontal del buffer
-        buffer.pop(); // Elimina el ítem del buffer
-        std::stringstream ss;  // Crear un stringstream para construir el mensaje
-        ss << "Consumidor " << id << " consumió: " << item << "\n"; // Mensaje de consumo
-        printMessage(ss.str()); // Llama a la función para imprimir y escribir en el archivo
-        buffer_mutex.release(); // Libera el semáforo después de modificar el buffer
-        spaces.release(); // Indica que hay un espacio disponible en el buffer
-        return item; // Retorna el ítem consumido
-    }
-
-    // Método para mostrar los ítems restantes en el buffer
-    void showRemainingItems() {
-        buffer_mutex.acquire(); // Adquiere el semáforo para acceder al buffer
-        std::stringstream ss;  // Crear un stringstream para construir el mensaje
-        ss << "Elementos restantes en el buffer: "; // Mensaje de inicio
-        if (buffer.empty()) { // Verifica si el buffer está vacío
-            ss << "El buffer está vacío.\n"; // Mensaje si el buffer está vacío
-        } else {
-            queue<int> temp = buffer; // Copia temporal del buffer
-            while (!temp.empty()) { // Recorre la copia temporal
-                ss << temp.front() << " "; // Agrega cada ítem al mensaje
-                temp.pop(); // Elimina el ítem de la copia
+    // Bucle de cada hilo: toma la próxima tarea lista, ejecuta un paso fuera del candado y la reprograma.
+    // Una tarea bloqueada se estaciona en la lista de su lado; cada paso que avanza despierta a una
+    // sola tarea del otro lado (un ítem insertado puede destrabar a un consumidor y un espacio liberado,
+    // a un productor), así que cada paso cuesta lo mismo sin importar cuántas tareas esperan. Si el
+    // otro lado avanzó mientras se ejecutaba el paso bloqueado, la tarea reintenta de inmediato para
+    // no perder ese aviso. Una tarea que termina despierta además a un consumidor: cuando el último
+    // productor cierra el buffer, cada consumidor que termina despierta al siguiente
+    void work() {
+        unique_lock<mutex> lock(queue_mutex);
+        while (remaining > 0) {
+            Clock::time_point now = Clock::now();
+            while (!sleeping.empty() && sleeping.top().first <= now) {
+                ready.push_back(sleeping.top().second);  // Terminó la pausa
+                sleeping.pop();
+            }
+            if (ready.empty()) {
+                if (sleeping.empty()) {
+                    changed.wait(lock);
+                } else {
+                    changed.wait_until(lock, sleeping.top().first);
+                }
+                continue;
+            }
+            size_t index = ready.front();
+            ready.pop_front();
+            bool producer = roles[index] == TaskRole::Productor;
+            uint64_t& other_steps = producer ? consumer_steps : producer_steps;  // Avances que pueden destrabarla
+            uint64_t seen = other_steps;
+            lock.unlock();
+            TaskStep step = tasks[index]();
+            lock.lock();
+            if (step.kind == TaskStep::Kind::Bloqueado) {
+                if (other_steps == seen) {
+                    (producer ? waiting_space : waiting_items).push_back(index);  // Esperar sin ocupar el hilo
+                } else {
+                    ready.push_back(index);  // El otro lado avanzó durante el paso: reintentar
+                    changed.notify_one();
+                }
+                continue;
+            }
+            ++(producer ? producer_steps : consumer_steps);
+            wakeOne(producer ? waiting_items : waiting_space);
+            if (step.kind == TaskStep::Kind::Terminado && !producer) {
+                wakeOne(waiting_items);  // Propagar el cierre del buffer al siguiente consumidor
             }
-            ss << "\n"; // Salto de línea al final
+            switch (step.kind) {
+            case TaskStep::Kind::Listo:
+            case TaskStep::Kind::Bloqueado:
+                ready.push_back(index);
+                break;
+            case TaskStep::Kind::Pausa:
+                sleeping.emplace(Clock::now() + step.pause, index);
+                break;
+            case TaskStep::Kind::Terminado:
+                --remaining;
+                break;
+            }
+            changed.notify_one();  // Otro hilo puede tener una tarea nueva o un temporizador más próximo
+        }
+        changed.notify_all();  // Todas las tareas terminaron: despertar a los demás hilos para que salgan
+    }
+};
+
+class CoroutineScheduler;
+
+// Corrutina de un productor o consumidor. Comienza suspendida hasta que el planificador la ejecuta
+// y su marco se destruye solo al terminar, avisando al planificador
+struct CoTask {
+    struct promise_type {
+        CoroutineScheduler* scheduler = nullptr;  // Planificador al que se avisa el término
+
+        CoTask get_return_object() { return CoTask{coroutine_handle<promise_type>::from_promise(*this)}; }
+        suspend_always initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+        ~promise_type();
+    };
+
+    coroutine_handle<promise_type> handle;
+};
+
+// Planificador que reparte muchas corrutinas sobre pocos hilos. Las corrutinas listas esperan en
+// una cola y las que duermen la pausa de su carga, en una cola de temporizadores; suspender una
+// corrutina solo guarda su marco, sin bloquear ningún hilo
+class CoroutineScheduler {
+private:
+    using Clock = chrono::steady_clock;
+    using Timer = pair<Clock::time_point, void*>;  // Momento de reanudación y dirección de la corrutina
+
+    mutex queue_mutex;              // Protege las colas y el contador de corrutinas vivas
+    condition_variable changed;     // Avisa que hay corrutinas listas o que todas terminaron
+    deque<coroutine_handle<>> ready; // Corrutinas que pueden continuar
+    priority_queue<Timer, vector<Timer>, greater<Timer>> sleeping;  // Corrutinas en pausa, la más próxima primero
+    size_t live = 0;                // Corrutinas que aún no terminan
+
+public:
+    // Espera que suspende la corrutina durante `pause` sin ocupar un hilo
+    struct SleepAwaiter {
+        CoroutineScheduler& scheduler;
+        chrono::nanoseconds pause;
+
+        bool await_ready() const { return pause <= chrono::nanoseconds::zero(); }
+        void await_suspend(coroutine_handle<> handle) { scheduler.scheduleAt(Clock::now() + pause, handle); }
+        void await_resume() const {}
+    };
+
+    // Registra una corrutina y la deja lista para ejecutarse
+    void spawn(CoTask task) {
+        task.handle.promise().scheduler = this;
+        {
+            lock_guard<mutex> lock(queue_mutex);
+            ++live;
+        }
+        schedule(task.handle);
+    }
+
+    // Deja una corrutina suspendida lista para continuar
+    void schedule(coroutine_handle<> handle) {
+        {
+            lock_guard<mutex> lock(queue_mutex);
+            ready.push_back(handle);
+        }
+        changed.notify_one();
+    }
+
+    // Suspende la corrutina actual durante `pause` (co_await scheduler.sleepFor(pausa))
+    SleepAwaiter sleepFor(chrono::nanoseconds pause) {
+        return {*this, pause};
+    }
+
+    // Ejecuta las corrutinas con `threads` hilos y retorna cuando terminaron todas
+    void run(unsigned threads) {
+        vector<thread> workers;
+        for (unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back([this] { work(); });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Lo llama cada corrutina al destruirse
+    void taskFinished() {
+        lock_guard<mutex> lock(queue_mutex);
+        if (--live == 0) {
+            changed.notify_all();  // Todas terminaron: despertar a los hilos para que salgan
+        }
+    }
+
+private:
+    void scheduleAt(Clock::time_point when, coroutine_handle<> handle) {
+        {
+            lock_guard<mutex> lock(queue_mutex);
+            sleeping.emplace(when, handle.address());
+        }
+        changed.notify_one();  // Puede ser el temporizador más próximo
+    }
+
+    // Bucle de cada hilo: reanuda la próxima corrutina lista fuera del candado
+    void work() {
+        unique_lock<mutex> lock(queue_mutex);
+        while (live > 0) {
+            Clock::time_point now = Clock::now();
+            while (!sleeping.empty() && sleeping.top().first <= now) {
+                ready.push_back(coroutine_handle<>::from_address(sleeping.top().second));  // Terminó la pausa
+                sleeping.pop();
+            }
+            if (ready.empty()) {
+                if (sleeping.empty()) {
+                    changed.wait(lock);
+                } else {
+                    changed.wait_until(lock, sleeping.top().first);
+                }
+                continue;
+            }
+            coroutine_handle<> handle = ready.front();
+            ready.pop_front();
+            lock.unlock();
+            handle.resume();  // Corre hasta su próxima suspensión o hasta terminar
+            lock.lock();
+        }
+    }
+};
+
+inline CoTask::promise_type::~promise_type() {
+    if (scheduler != nullptr) {
+        scheduler->taskFinished();
+    }
+}
+
+// Adaptador del buffer para corrutinas: `co_await channel.produce(id, x)` y
+// `co_await channel.consume(id)` suspenden la corrutina cuando el buffer está lleno o vacío.
+// Las corrutinas suspendidas esperan en listas propias; quien libera un espacio (o inserta un
+// ítem) completa la operación pendiente de la primera en espera y la devuelve al planificador.
+// Cada lado anuncia sus esperas en un contador atómico antes de reintentar, y el otro lado lo
+// revisa después de modificar el buffer, de modo que ninguna espera queda sin atender
+template <typename T>
+class AwaitableBuffer {
+private:
+    struct ProduceAwaiter;
+    struct ConsumeAwaiter;
+
+    Buffer<T>& buffer;              // Buffer compartido
+    CoroutineScheduler& scheduler;  // Planificador que reanuda las corrutinas atendidas
+    atomic<int> producers_left;     // Productores que aún no terminan (el último cierra el buffer)
+    mutex waiters_mutex;            // Protege las listas de espera
+    deque<ProduceAwaiter*> waiting_producers;  // Inserciones pendientes por buffer lleno
+    deque<ConsumeAwaiter*> waiting_consumers;  // Consumos pendientes por buffer vacío
+    atomic<size_t> producer_waiters{0};        // Tamaño de waiting_producers, visible sin el candado
+    atomic<size_t> consumer_waiters{0};        // Tamaño de waiting_consumers, visible sin el candado
+
+    // Inserción que se completa de inmediato o queda pendiente en waiting_producers
+    struct ProduceAwaiter {
+        AwaitableBuffer& channel;
+        int id;
+        T item;
+        coroutine_handle<> handle;
+        ThreadMetrics* metrics = CURRENT_METRICS;  // Métricas de la corrutina que espera
+        bool inserted = false;      // El ítem quedó (o quedará, al atenderla) en el buffer
+        uint64_t suspended_ns = 0;  // Momento en que se suspendió (0: no se suspendió)
+
+        bool await_ready() {
+            OfferResult result = channel.buffer.tryOffer(id, item);  // Aplica la política de desborde
+            if (result == OfferResult::Lleno) {
+                return false;
+            }
+            if (result == OfferResult::Insertado) {
+                inserted = true;
+                channel.serveConsumer();
+            }
+            return true;
+        }
+
+        bool await_suspend(coroutine_handle<> waiting) {
+            handle = waiting;
+            inserted = true;  // Desde aquí el ítem se inserta, ya sea ahora o al atenderla
+            {
+                lock_guard<mutex> lock(channel.waiters_mutex);
+                suspended_ns = elapsedNanoseconds();  // Antes de quedar visible para quien la reanuda
+                channel.waiting_producers.push_back(this);
+                channel.producer_waiters.store(channel.waiting_producers.size());
+                atomic_thread_fence(memory_order_seq_cst);  // Anunciar la espera antes de reintentar
+                if (!channel.buffer.tryProduce(id, std::move(item))) {
+                    channel.buffer.countProducerWait();
+                    return true;  // Queda suspendida hasta que un consumidor libere un espacio
+                }
+                suspended_ns = 0;
+                channel.waiting_producers.pop_back();
+                channel.producer_waiters.store(channel.waiting_producers.size());
+            }
+            channel.serveConsumer();
+            return false;
+        }
+
+        // Se ejecuta en el hilo que continúa la corrutina, el único que escribe sus métricas
+        void await_resume() const {
+            if (metrics) {
+                metrics->produced += inserted;
+                recordSuspension(metrics, suspended_ns);
+            }
+        }
+    };
+
+    // Consumo que se completa de inmediato o queda pendiente en waiting_consumers
+    struct ConsumeAwaiter {
+        AwaitableBuffer& channel;
+        int id;
+        LatencyHistogram* latency;
+        optional<T> item;
+        coroutine_handle<> handle;
+        ThreadMetrics* metrics = CURRENT_METRICS;  // Métricas de la corrutina que espera
+        uint64_t suspended_ns = 0;  // Momento en que se suspendió (0: no se suspendió)
+
+        bool await_ready() {
+            bool closed = channel.buffer.isClosed();  // Leído antes de mirar el buffer para no perder ítems
+            if (!tryTake()) {
+                return closed;  // Cerrado y vacío: retorna un valor vacío sin suspender
+            }
+            channel.serveProducer();
+            return true;
+        }
+
+        bool await_suspend(coroutine_handle<> waiting) {
+            handle = waiting;
+            {
+                lock_guard<mutex> lock(channel.waiters_mutex);
+                bool closed = channel.buffer.isClosed();
+                suspended_ns = elapsedNanoseconds();  // Antes de quedar visible para quien la reanuda
+                channel.waiting_consumers.push_back(this);
+                channel.consumer_waiters.store(channel.waiting_consumers.size());
+                atomic_thread_fence(memory_order_seq_cst);  // Anunciar la espera antes de reintentar
+                bool taken = tryTake();
+                if (!taken && !closed) {
+                    return true;  // Queda suspendida hasta que un productor inserte o se cierre el buffer
+                }
+                suspended_ns = 0;
+                channel.waiting_consumers.pop_back();
+                channel.consumer_waiters.store(channel.waiting_consumers.size());
+                if (!taken) {
+                    return false;
+                }
+            }
+            channel.serveProducer();
+            return false;
+        }
+
+        // Se ejecuta en el hilo que continúa la corrutina, el único que escribe sus métricas
+        optional<T> await_resume() {
+            if (metrics) {
+                metrics->consumed += item.has_value();
+                recordSuspension(metrics, suspended_ns);
+            }
+            return std::move(item);
+        }
+
+        // Intenta tomar un ítem del buffer sin esperar
+        bool tryTake() {
+            T value;
+            if (channel.buffer.tryConsumeN(id, span<T>(&value, 1), latency) == 0) {
+                return false;
+            }
+            item.emplace(std::move(value));
+            return true;
+        }
+    };
+
+    // Cuenta como espera el tiempo que una corrutina estuvo suspendida en una lista de espera
+    static void recordSuspension(ThreadMetrics* metrics, uint64_t suspended_ns) {
+        if (suspended_ns != 0) {
+            metrics->waits++;
+            metrics->blocked_ns += elapsedNanoseconds() - suspended_ns;
+        }
+    }
+
+    // Tras liberar un espacio: completa la inserción pendiente más antigua, si la hay
+    void serveProducer() {
+        atomic_thread_fence(memory_order_seq_cst);  // Modificar el buffer antes de revisar las esperas
+        if (producer_waiters.load() == 0) {
+            return;
+        }
+        ProduceAwaiter* served = nullptr;
+        {
+            lock_guard<mutex> lock(waiters_mutex);
+            if (!waiting_producers.empty()) {
+                ProduceAwaiter* waiter = waiting_producers.front();
+                if (buffer.tryProduce(waiter->id, std::move(waiter->item))) {
+                    waiting_producers.pop_front();
+                    producer_waiters.store(waiting_producers.size());
+                    served = waiter;
+                }
+            }
+        }
+        if (served != nullptr) {
+            scheduler.schedule(served->handle);
+            serveConsumer();  // La inserción completada puede atender a un consumidor en espera
+        }
+    }
+
+    // Tras insertar un ítem: completa el consumo pendiente más antiguo, si lo hay
+    void serveConsumer() {
+        atomic_thread_fence(memory_order_seq_cst);  // Modificar el buffer antes de revisar las esperas
+        if (consumer_waiters.load() == 0) {
+            return;
+        }
+        ConsumeAwaiter* served = nullptr;
+        {
+            lock_guard<mutex> lock(waiters_mutex);
+            if (!waiting_consumers.empty()) {
+                ConsumeAwaiter* waiter = waiting_consumers.front();
+                if (waiter->tryTake()) {
+                    waiting_consumers.pop_front();
+                    consumer_waiters.store(waiting_consumers.size());
+                    served = waiter;
+                }
+            }
+        }
+        if (served != nullptr) {
+            scheduler.schedule(served->handle);
+            serveProducer();  // El consumo completado libera un espacio para un productor en espera
+        }
+    }
+
+public:
+    AwaitableBuffer(Buffer<T>& buffer, CoroutineScheduler& scheduler, int producers)
+        : buffer(buffer), scheduler(scheduler), producers_left(producers) {}
+
+    // Inserta un ítem; suspende la corrutina mientras el buffer esté lleno
+    ProduceAwaiter produce(int id, T item) {
+        return {*this, id, std::move(item), {}, CURRENT_METRICS};
+    }
+
+    // Toma un ítem; suspende la corrutina mientras el buffer esté vacío. Retorna un valor vacío
+    // cuando el buffer está cerrado y vacío
+    ConsumeAwaiter consume(int id, LatencyHistogram* latency = nullptr) {
+        return {*this, id, latency, nullopt, {}, CURRENT_METRICS};
+    }
+
+    // Lo llama cada productor al terminar; el último cierra el buffer y despierta a los consumidores
+    // en espera, que reciben los ítems que queden o un valor vacío
+    void producerDone() {
+        if (producers_left.fetch_sub(1) != 1) {
+            return;
+        }
+        buffer.close();
+        vector<coroutine_handle<>> woken;
+        {
+            lock_guard<mutex> lock(waiters_mutex);
+            for (ConsumeAwaiter* waiter : waiting_consumers) {
+                waiter->tryTake();
+                woken.push_back(waiter->handle);
+            }
+            waiting_consumers.clear();
+            consumer_waiters.store(0);
+        }
+        for (coroutine_handle<> handle : woken) {
+            scheduler.schedule(handle);
         }
-        printMessage(ss.str()); // Llama a la función para imprimir y escribir en el archivo
-        buffer_mutex.release(); // Libera el semáforo después de mostrar los ítems
     }
 };
 
@@ -116,114 +796,727 @@ public:
 class Producer {
 private:
     int id; // Identificador del productor
-    Buffer& buffer; // Referencia al buffer compartido
+    Buffer<int>& buffer; // Referencia al buffer compartido
+    ThreadMetrics& metrics; // Contadores de este productor
+    Workload workload; // Carga aplicada después de cada producción
+    int next_item = -1; // Próximo ítem de la tarea del ejecutor (-1: aún no comenzó)
+    TaskWait waiting; // Espera de la tarea por el ítem actual
 
 public:
-    // Constructor que inicializa el identificador y la referencia al buffer
-    Producer(int id, Buffer& buffer) : id(id), buffer(buffer) {}
+    // Constructor que inicializa el identificador, la referencia al buffer, las métricas y la carga
+    Producer(int id, Buffer<int>& buffer, ThreadMetrics& metrics, Workload workload = PRODUCER_WORKLOAD)
+        : id(id), buffer(buffer), metrics(metrics), workload(workload) {
+        this->workload.seed(2 * id);  // Semilla distinta para cada productor
+    }
 
     // Sobrecarga del operador () para que la clase se pueda usar como un hilo
     void operator()() {
-        {
-            std::stringstream ss;  // Crear un stringstream para construir el mensaje
-            ss << "Productor " << id << " creado.\n"; // Mensaje de creación del productor
-            printMessage(ss.str()); // Llama a la función para imprimir y escribir en el archivo
-        }
+        CURRENT_METRICS = &metrics; // El buffer registra las esperas y el uso del candado de este hilo
+        logger.logEvent(EventType::ProductorCreado, id); // Mensaje de creación del productor
 
         // Bucle para producir N ítems
-        for (int i = 0; i < N; ++i) {
-            int item = id * 100 + i; // Generar un ítem único basado en el id del productor
-            buffer.produce(id, item); // Llama al método para producir el ítem en el buffer
-            this_thread::sleep_for(chrono::milliseconds(2000)); // Espera 2 segundos entre producciones
+        if (BATCH_SIZE == 1) {
+            for (int i = 0; i < N; ++i) {
+                int item = id * 100 + i; // Generar un ítem único basado en el id del productor
+                metrics.produced += buffer.produce(id, item); // Llama al método para producir el ítem en el buffer
+                workload.apply(); // Espera o trabajo entre producciones según el modelo de carga
+            }
+        } else {
+            // Acumula BATCH_SIZE ítems y los entrega con una sola llamada al buffer
+            array<int, MAX_BATCH> batch;
+            size_t count = 0;
+            for (int i = 0; i < N; ++i) {
+                batch[count++] = id * 100 + i; // Generar un ítem único basado en el id del productor
+                workload.apply(); // Espera o trabajo de cada ítem según el modelo de carga
+                if (count == static_cast<size_t>(BATCH_SIZE) || i == N - 1) {
+                    metrics.produced += buffer.produceN(id, span<int>(batch.data(), count)); // Entrega el lote completo
+                    count = 0;
+                }
+            }
         }
 
-        {
-            std::stringstream ss;  // Crear un stringstream para construir el mensaje
-            ss << "Productor " << id << " ha terminado.\n"; // Mensaje de finalización del productor
-            printMessage(ss.str()); // Llama a la función para imprimir y escribir en el archivo
+        logger.logEvent(EventType::ProductorTerminado, id); // Mensaje de finalización del productor
+    }
+
+    // Un paso como tarea del ejecutor: intenta insertar el próximo ítem sin bloquear el hilo
+    TaskStep step() {
+        CURRENT_METRICS = &metrics; // Las tareas comparten hilos: se activan sus métricas en cada paso
+        if (next_item < 0) {
+            logger.logEvent(EventType::ProductorCreado, id); // Mensaje de creación del productor
+            next_item = 0;
+        }
+        if (next_item == N) {
+            logger.logEvent(EventType::ProductorTerminado, id); // Mensaje de finalización del productor
+            return {TaskStep::Kind::Terminado};
+        }
+        // El primer intento aplica la política de desborde; si pide esperar espacio, los reintentos
+        // del mismo ítem ya no vuelven a aplicarla
+        int item = id * 100 + next_item;
+        OfferResult result = !waiting.active() ? buffer.tryOffer(id, item)
+                                               : (buffer.tryProduce(id, item) ? OfferResult::Insertado : OfferResult::Lleno);
+        if (result == OfferResult::Lleno) {
+            if (!waiting.active()) {
+                buffer.countProducerWait();
+                waiting.begin(metrics);
+            }
+            return {TaskStep::Kind::Bloqueado}; // Buffer lleno: ceder el hilo
         }
+        ++next_item;
+        metrics.produced += result == OfferResult::Insertado;
+        waiting.end(metrics);
+        return TaskStep::after(workload.next()); // Pausa entre producciones según el modelo de carga
+    }
+
+    // Versión corrutina: inserta con co_await, de modo que esperar espacio o la pausa de la carga
+    // suspende la corrutina sin bloquear el hilo
+    static CoTask coroutine(Producer self, AwaitableBuffer<int>& channel, CoroutineScheduler& scheduler) {
+        logger.logEvent(EventType::ProductorCreado, self.id); // Mensaje de creación del productor
+        for (int i = 0; i < N; ++i) {
+            CURRENT_METRICS = &self.metrics; // La corrutina puede continuar en otro hilo después de cada co_await
+            co_await channel.produce(self.id, self.id * 100 + i); // Generar un ítem único basado en el id del productor
+            co_await scheduler.sleepFor(self.workload.next()); // Pausa entre producciones según el modelo de carga
+        }
+        logger.logEvent(EventType::ProductorTerminado, self.id); // Mensaje de finalización del productor
+        channel.producerDone();
     }
 };
 
 // Clase Consumidor
+using LocalQueues = vector<unique_ptr<WorkStealingDeque<int>>>;  // Deque local de cada consumidor (modo con robo)
+
 class Consumer {
 private:
     int id; // Identificador del consumidor
-    Buffer& buffer; // Referencia al buffer compartido
+    Buffer<int>& buffer; // Referencia al buffer compartido
+    LatencyHistogram& latency; // Latencias de los ítems consumidos por este hilo
+    LocalQueues& queues; // Deques locales de todos los consumidores (vacío si no hay robo)
+    uint64_t& stolen; // Ítems que este consumidor robó a otros
+    ThreadMetrics& metrics; // Contadores de este consumidor
+    Workload workload; // Carga aplicada después de cada consumo
+    int consumed = -1; // Ítems consumidos por la tarea del ejecutor (-1: aún no comenzó)
+    TaskWait waiting; // Espera de la tarea por el próximo ítem
 
 public:
-    // Constructor que inicializa el identificador y la referencia al buffer
-    Consumer(int id, Buffer& buffer) : id(id), buffer(buffer) {}
+    // Constructor que inicializa el identificador, la referencia al buffer, el histograma, las métricas y la carga
+    Consumer(int id, Buffer<int>& buffer, LatencyHistogram& latency, LocalQueues& queues, uint64_t& stolen,
+             ThreadMetrics& metrics, Workload workload = CONSUMER_WORKLOAD)
+        : id(id), buffer(buffer), latency(latency), queues(queues), stolen(stolen), metrics(metrics), workload(workload) {
+        this->workload.seed(2 * id + 1);  // Semilla distinta para cada consumidor
+    }
 
-    // Sobrecarga del operador () para que la clase se pueda usar como un hilo
-    void operator()() {
-        {
-            std::stringstream ss;  // Crear un stringstream para construir el mensaje
-            ss << "Consumidor " << id << " creado.\n"; // Mensaje de creación del consumidor
-            printMessage(ss.str()); // Llama a la función para imprimir y escribir en el archivo
+    // Sobrecarga del operador () para que la clase se pueda usar como un hilo (std::jthread entrega el stop_token)
+    void operator()(stop_token stop) {
+        CURRENT_METRICS = &metrics; // El buffer registra las esperas y el uso del candado de este hilo
+        logger.logEvent(EventType::ConsumidorCreado, id); // Mensaje de creación del consumidor
+        if (STEAL_BATCH > 0) {
+            consumeStealing(stop);
+        } else {
+            consumeShared(stop);
+        }
+        logger.logEvent(EventType::ConsumidorTerminado, id); // Mensaje de finalización del consumidor
+    }
+
+    // Un paso como tarea del ejecutor: intenta consumir el próximo ítem sin bloquear el hilo
+    TaskStep step() {
+        CURRENT_METRICS = &metrics; // Las tareas comparten hilos: se activan sus métricas en cada paso
+        if (consumed < 0) {
+            logger.logEvent(EventType::ConsumidorCreado, id); // Mensaje de creación del consumidor
+            consumed = 0;
+        }
+        if (consumed < N) {
+            bool closed = buffer.isClosed();  // Leído antes de mirar el buffer para no perder ítems
+            int item;
+            if (buffer.tryConsumeN(id, span<int>(&item, 1), &latency) == 1) {
+                ++consumed;
+                metrics.consumed++;
+                waiting.end(metrics);
+                return TaskStep::after(workload.next()); // Pausa entre consumos según el modelo de carga
+            }
+            if (!closed) {
+                waiting.begin(metrics);
+                return {TaskStep::Kind::Bloqueado}; // Buffer vacío: ceder el hilo
+            }
         }
+        waiting.end(metrics);
+        logger.logEvent(EventType::ConsumidorTerminado, id); // Mensaje de finalización del consumidor
+        return {TaskStep::Kind::Terminado};
+    }
 
-        // Bucle para consumir N ítems
+    // Versión corrutina: consume con co_await hasta N ítems o hasta que el buffer se cierre y quede vacío
+    static CoTask coroutine(Consumer self, AwaitableBuffer<int>& channel, CoroutineScheduler& scheduler) {
+        logger.logEvent(EventType::ConsumidorCreado, self.id); // Mensaje de creación del consumidor
         for (int i = 0; i < N; ++i) {
-            int item = buffer.consume(id); // Llama al método para consumir un ítem del buffer
-            if (item != -1) { // Verifica si el ítem fue consumido correctamente
-                this_thread::sleep_for(chrono::milliseconds(1500)); // Espera 1.5 segundos entre consumos
+            CURRENT_METRICS = &self.metrics; // La corrutina puede continuar en otro hilo después de cada co_await
+            optional<int> item = co_await channel.consume(self.id, &self.latency);
+            if (!item) { // No quedan ítems
+                break;
             }
+            co_await scheduler.sleepFor(self.workload.next()); // Pausa entre consumos según el modelo de carga
         }
+        logger.logEvent(EventType::ConsumidorTerminado, self.id); // Mensaje de finalización del consumidor
+    }
 
-        {
-            std::stringstream ss;  // Crear un stringstream para construir el mensaje
-            ss << "Consumidor " << id << " ha terminado.\n"; // Mensaje de finalización del consumidor
-            printMessage(ss.str()); // Llama a la función para imprimir y escribir en el archivo
+private:
+    // Consumo directo del buffer compartido
+    void consumeShared(stop_token stop) {
+        // Bucle para consumir hasta N ítems (de a BATCH_SIZE por llamada); termina antes si el
+        // buffer se cerró y quedó vacío
+        array<int, MAX_BATCH> batch;
+        for (int consumed = 0; consumed < N;) {
+            size_t wanted = min<size_t>(BATCH_SIZE, N - consumed);
+            size_t count = buffer.consumeN(id, span<int>(batch.data(), wanted), stop, &latency); // Llama al método para consumir ítems del buffer
+            if (count == 0) { // No quedan ítems o se pidió detener
+                break;
+            }
+            for (size_t j = 0; j < count; ++j) {
+                workload.apply(); // Espera o trabajo entre consumos según el modelo de carga
+            }
+            consumed += static_cast<int>(count);
+            metrics.consumed += count;
+        }
+    }
+
+    // Consumo con robo de trabajo: el consumidor pasa lotes de STEAL_BATCH ítems del buffer a su
+    // deque local y los procesa desde allí; si el buffer está vacío roba ítems pendientes de los
+    // deques de otros consumidores. No hay cuota de N ítems: termina cuando el buffer está cerrado
+    // y vacío y no queda nada que robar (cada dueño procesa lo que queda en su propio deque)
+    void consumeStealing(stop_token stop) {
+        WorkStealingDeque<int>& own = *queues[id - 1];
+        array<int, MAX_BATCH> batch;
+        while (true) {
+            optional<int> item = own.pop();
+            if (!item) {
+                bool finished = false;
+                retryUntil([&] {
+                    bool closed = buffer.isClosed();  // Leído antes de mirar el buffer para no perder ítems
+                    size_t count = buffer.tryConsumeN(id, span<int>(batch.data(), STEAL_BATCH), &latency);
+                    for (size_t j = 0; j < count; ++j) {
+                        own.push(batch[j]);  // Nunca se llena: el deque solo se recarga cuando está vacío
+                    }
+                    if (count > 0 && (item = own.pop())) {
+                        return true;
+                    }
+                    item = steal();
+                    finished = (!item && closed) || stop.stop_requested();
+                    return item.has_value() || finished;
+                }, NO_DEADLINE, WAIT_STRATEGY, &buffer.consumerSpin());
+                if (!item) {
+                    break; // No hay más ítems que consumir o se pidió detener
+                }
+            }
+            metrics.consumed++;
+            workload.apply(); // Espera o trabajo del ítem según el modelo de carga
+        }
+    }
+
+    // Intenta robar un ítem recorriendo los deques de los demás consumidores desde el siguiente
+    optional<int> steal() {
+        for (size_t k = 1; k < queues.size(); ++k) {
+            optional<int> item = queues[(id - 1 + k) % queues.size()]->steal();
+            if (item) {
+                ++stolen;
+                logger.logEvent(EventType::Robo, id, *item);
+                return item;
+            }
+        }
+        return nullopt;
+    }
+};
+
+// Trabajo de un trabajador de una etapa: ítems que pasó a la siguiente y cuándo tomó el primero y
+// entregó el último, para medir la etapa solo mientras estuvo activa
+struct StageTally {
+    uint64_t processed = 0;  // Ítems que pasó a la siguiente etapa
+    uint64_t first_ns = 0;   // Momento en que tomó su primer ítem
+    uint64_t last_ns = 0;    // Momento en que entregó su último ítem
+};
+
+// Clase Trabajador de una etapa intermedia del pipeline
+class StageWorker {
+private:
+    int id; // Identificador del trabajador (distinto del de productores y trabajadores de otras etapas)
+    const StageConfig& stage; // Etapa a la que pertenece
+    Buffer<int>& input; // Buffer del que toma los ítems
+    Buffer<int>& output; // Buffer al que pasa los ítems
+    StageTally& tally; // Trabajo realizado (se escribe al terminar)
+    Workload workload; // Carga aplicada a cada ítem
+
+public:
+    // Constructor que inicializa el identificador, la etapa, los buffers y el registro de trabajo
+    StageWorker(int id, const StageConfig& stage, Buffer<int>& input, Buffer<int>& output, StageTally& tally)
+        : id(id), stage(stage), input(input), output(output), tally(tally), workload(stage.workload) {
+        workload.seed(3 * id);  // Semilla distinta para cada trabajador
+    }
+
+    // Sobrecarga del operador () para que la clase se pueda usar como un hilo. Sin cuota de ítems:
+    // trabaja hasta que la etapa anterior cierra su buffer y este queda vacío
+    void operator()() {
+        MessageBuilder created;
+        created << "Trabajador " << id << " de la etapa " << stage.name << " creado.\n";
+        printMessage(created.view());
+
+        array<int, MAX_BATCH> batch;
+        StageTally local;
+        while (size_t taken = input.consumeN(id, span<int>(batch.data(), BATCH_SIZE))) {
+            if (local.processed == 0) {
+                local.first_ns = elapsedNanoseconds();
+            }
+            for (size_t j = 0; j < taken; ++j) {
+                workload.apply(); // Trabajo de la etapa sobre cada ítem
+            }
+            local.processed += output.produceN(id, span<int>(batch.data(), taken)); // Pasa el lote; cuenta solo los que quedaron en el buffer
+            local.last_ns = elapsedNanoseconds();
         }
+        tally = local;  // Un solo acceso al registro compartido, al terminar
+
+        MessageBuilder finished;
+        finished << "Trabajador " << id << " de la etapa " << stage.name << " ha terminado.\n";
+        printMessage(finished.view());
     }
 };
 
 // Clase Principal para ejecutar el programa
 class Principal {
 private:
-    Buffer buffer; // Instancia del buffer
+    // Muestras periódicas de la cantidad de ítems de un buffer
+    struct DepthSamples {
+        uint64_t sum = 0;      // Suma de las muestras
+        uint64_t samples = 0;  // Cantidad de muestras
+        size_t max = 0;        // Mayor cantidad observada
+    };
+
+    Buffer<int> buffer; // Instancia del buffer
     vector<thread> producers; // Vector para almacenar los hilos de productores
-    vector<thread> consumers; // Vector para almacenar los hilos de consumidores
+    vector<jthread> consumers; // Vector para almacenar los hilos de consumidores (cancelables)
+    vector<LatencyHistogram> latencies; // Histograma de latencias de cada consumidor
+    LocalQueues local_queues; // Deque local de cada consumidor (solo con robo de trabajo)
+    vector<uint64_t> steals; // Ítems robados por cada consumidor
+    vector<ThreadMetrics> producer_metrics; // Contadores de cada productor (cada uno en su línea de caché)
+    vector<ThreadMetrics> consumer_metrics; // Contadores de cada consumidor (cada uno en su línea de caché)
+    vector<unique_ptr<Buffer<int>>> stage_buffers; // Buffer de salida de cada etapa del pipeline (el último alimenta a los consumidores)
+    vector<vector<StageTally>> stage_tallies; // Trabajo de cada trabajador de cada etapa
+    vector<DepthSamples> depths; // Ocupación de cada buffer del pipeline (entrada de cada etapa y de los consumidores)
 
 public:
-    // Constructor que inicializa el buffer con la capacidad proporcionada
-    Principal(int capacity) : buffer(capacity) {}
+    // Constructor que inicializa el buffer con la capacidad proporcionada, y un buffer de la misma
+    // capacidad a la salida de cada etapa del pipeline (cada buffer elige el anillo SPSC
+    // automáticamente si tiene un solo productor y un solo consumidor)
+    Principal(int capacity)
+        : buffer(capacity, resolveBufferMode(BUFFER_MODE, NP, stageWorkers(0)), LANES > 0 ? LANES : NP) {
+        for (size_t s = 0; s < STAGES.size(); ++s) {
+            int writers = STAGES[s].workers;
+            BufferMode mode = resolveBufferMode(BUFFER_MODE, writers, stageWorkers(s + 1));
+            stage_buffers.push_back(make_unique<Buffer<int>>(capacity, mode, LANES > 0 ? LANES : writers));
+        }
+    }
 
     // Método para ejecutar la lógica principal
     void run() {
+        latencies.resize(NC); // Cada consumidor registra latencias en su propio histograma
+        steals.resize(NC);
+        producer_metrics.resize(NP);
+        consumer_metrics.resize(NC);
+        uint64_t start_ns = elapsedNanoseconds();
+        if (USE_EXECUTOR || SIMULATE) {
+            runTasks();
+        } else if (USE_COROUTINES) {
+            runCoroutines();
+        } else {
+            runThreads();
+        }
+        uint64_t elapsed_ns = SIMULATE ? VIRTUAL_NOW_NS : elapsedNanoseconds() - start_ns;  // La simulación parte del instante virtual 0
+
+        buffer.showRemainingItems(); // Muestra los ítems restantes en el buffer
+        for (auto& stage_buffer : stage_buffers) {
+            stage_buffer->showRemainingItems();
+        }
+
+        // Los buffers de las etapas usan la misma política de desborde: se suman sus esperas y pérdidas
+        OverflowStats stats = buffer.overflowStats();
+        for (auto& stage_buffer : stage_buffers) {
+            stats += stage_buffer->overflowStats();
+        }
+        MessageBuilder message;  // Construir el mensaje sin memoria dinámica
+        message << (STAGES.empty() ? "Veces que un productor encontró el buffer lleno: "
+                                   : "Veces que un productor o trabajador de etapa encontró un buffer lleno: ")
+                << stats.waits << "\n";
+        printMessage(message.view()); // Llama a la función para imprimir y escribir en el archivo
+
+        if (OVERFLOW_POLICY != OverflowPolicy::Bloquear) {
+            MessageBuilder overflow;
+            overflow << "Ítems perdidos por buffer lleno: " << stats.rejected << " rechazados, " << stats.dropped_newest
+                     << " nuevos descartados, " << stats.dropped_oldest << " antiguos descartados, " << stats.shed
+                     << " descartados por muestreo\n";
+            printMessage(overflow.view());
+        }
+
+        if (STEAL_BATCH > 0) {
+            uint64_t total = 0;
+            for (uint64_t count : steals) {
+                total += count;
+            }
+            MessageBuilder stolen;
+            stolen << "Ítems robados entre consumidores: " << total << "\n";
+            printMessage(stolen.view());
+        }
+
+        if (!STAGES.empty()) {
+            showStages(); // Muestra el rendimiento y la ocupación de cada etapa
+        }
+        showMetrics(elapsed_ns); // Muestra los contadores de productores y consumidores
+        showLatencies(); // Muestra la latencia de encolado a desencolado
+    }
+
+    // Ejecuta cada productor y cada consumidor en su propio hilo
+    void runThreads() {
         // Crear hilos para los productores
         for (int i = 0; i < NP; ++i) {
-            producers.emplace_back(Producer(i + 1, buffer)); // Agrega un nuevo hilo productor
+            producers.emplace_back(Producer(i + 1, buffer, producer_metrics[i])); // Agrega un nuevo hilo productor
         }
 
         // Crear hilos para los consumidores
+        for (int i = 0; STEAL_BATCH > 0 && i < NC; ++i) {
+            local_queues.push_back(make_unique<WorkStealingDeque<int>>(MAX_BATCH));
+        }
         for (int i = 0; i < NC; ++i) {
-            consumers.emplace_back(Consumer(i + 1, buffer)); // Agrega un nuevo hilo consumidor
+            consumers.emplace_back(Consumer(i + 1, sink(), latencies[i], local_queues, steals[i], consumer_metrics[i])); // Agrega un nuevo hilo consumidor
+        }
+
+        // Crear los hilos de las etapas intermedias y un hilo que mide la ocupación de los buffers
+        vector<vector<thread>> workers(STAGES.size());
+        stage_tallies.resize(STAGES.size());
+        // Los trabajadores insertan y consumen como productores y consumidores, así que su numeración
+        // empieza después de la de ambos para que el log no confunda sus eventos con los de ellos
+        int next_id = max(NP, NC) + 1;
+        for (size_t s = 0; s < STAGES.size(); ++s) {
+            stage_tallies[s].resize(STAGES[s].workers);
+            Buffer<int>& input = s == 0 ? buffer : *stage_buffers[s - 1];
+            for (int k = 0; k < STAGES[s].workers; ++k) {
+                workers[s].emplace_back(StageWorker(next_id++, STAGES[s], input, *stage_buffers[s], stage_tallies[s][k]));
+            }
+        }
+        jthread monitor;
+        if (!STAGES.empty()) {
+            depths.resize(STAGES.size() + 1);
+            monitor = jthread([this](stop_token stop) { sampleDepths(stop); });
         }
 
         // Unir todos los hilos de productores
         for (auto& p : producers) {
             p.join(); // Espera a que cada productor termine
         }
+        buffer.close(); // No habrá más ítems: los consumidores vacían el buffer y terminan sin esperar
+
+        // Cada etapa termina cuando la anterior cerró su buffer y lo vació; entonces cierra el suyo
+        for (size_t s = 0; s < STAGES.size(); ++s) {
+            for (auto& w : workers[s]) {
+                w.join();
+            }
+            stage_buffers[s]->close();
+        }
 
         // Unir todos los hilos de consumidores
         for (auto& c : consumers) {
             c.join(); // Espera a que cada consumidor termine
         }
+    }
 
-        buffer.showRemainingItems(); // Muestra los ítems restantes en el buffer
+    // Ejecuta productores y consumidores como tareas de un ejecutor con EXECUTOR_THREADS hilos, o en
+    // el hilo actual sobre un reloj virtual cuando se pidió la simulación
+    void runTasks() {
+        Executor executor;
+        atomic<int> producers_left{NP};  // El último productor en terminar cierra el buffer
+        for (int i = 0; i < NP; ++i) {
+            executor.add([this, &producers_left, producer = Producer(i + 1, buffer, producer_metrics[i])]() mutable {
+                TaskStep step = producer.step();
+                if (step.kind == TaskStep::Kind::Terminado && producers_left.fetch_sub(1) == 1) {
+                    buffer.close(); // No habrá más ítems: los consumidores vacían el buffer y terminan
+                }
+                return step;
+            }, TaskRole::Productor);
+        }
+        for (int i = 0; i < NC; ++i) {
+            executor.add([consumer = Consumer(i + 1, buffer, latencies[i], local_queues, steals[i], consumer_metrics[i])]() mutable {
+                return consumer.step();
+            }, TaskRole::Consumidor);
+        }
+        if (!SIMULATE) {
+            executor.run(executorThreads());
+            return;
+        }
+        auto start = chrono::steady_clock::now();
+        bool finished = executor.simulate();
+        auto real_ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+        MessageBuilder message;  // Construir el mensaje sin memoria dinámica
+        if (!finished) {
+            message << "La simulación se detuvo: las tareas pendientes quedaron bloqueadas en el buffer.\n";
+        }
+        message << "Tiempo simulado: " << VIRTUAL_NOW_NS / 1000000 << " ms (" << real_ms << " ms reales, semilla "
+                << RANDOM_SEED << ")\n";
+        printMessage(message.view());
+    }
+
+    // Ejecuta productores y consumidores como corrutinas sobre EXECUTOR_THREADS hilos
+    void runCoroutines() {
+        CoroutineScheduler scheduler;
+        AwaitableBuffer<int> channel(buffer, scheduler, NP);
+        for (int i = 0; i < NP; ++i) {
+            scheduler.spawn(Producer::coroutine(Producer(i + 1, buffer, producer_metrics[i]), channel, scheduler));
+        }
+        for (int i = 0; i < NC; ++i) {
+            scheduler.spawn(Consumer::coroutine(Consumer(i + 1, buffer, latencies[i], local_queues, steals[i], consumer_metrics[i]), channel, scheduler));
+        }
+        scheduler.run(executorThreads());
+    }
+
+    // Trabajadores que consumen del buffer de entrada de la etapa `s` (los consumidores después de la última)
+    static int stageWorkers(size_t s) {
+        return s < STAGES.size() ? STAGES[s].workers : NC;
+    }
+
+    // Buffer del que leen los consumidores: el de salida de la última etapa, o el único si no hay etapas
+    Buffer<int>& sink() {
+        return stage_buffers.empty() ? buffer : *stage_buffers.back();
+    }
+
+    // Muestrea cada milisegundo la ocupación de los buffers del pipeline hasta que se pida detener
+    void sampleDepths(stop_token stop) {
+        while (!stop.stop_requested()) {
+            for (size_t s = 0; s < depths.size(); ++s) {
+                size_t depth = s == 0 ? buffer.depth() : stage_buffers[s - 1]->depth();
+                depths[s].sum += depth;
+                depths[s].samples++;
+                depths[s].max = max(depths[s].max, depth);
+            }
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+
+    // Muestra, para cada etapa, los ítems procesados, su rendimiento mientras estuvo activa y la
+    // ocupación del buffer del que lee; al final, la ocupación del buffer de los consumidores. Una
+    // etapa con el buffer de entrada casi siempre lleno es el cuello de botella del pipeline
+    void showStages() {
+        std::stringstream ss;  // Crear un stringstream para construir el mensaje (con decimales)
+        ss.setf(ios::fixed);
+        auto showDepth = [&](const DepthSamples& samples) {
+            double mean = samples.samples == 0 ? 0.0 : static_cast<double>(samples.sum) / samples.samples;
+            ss.precision(1);
+            ss << "ocupación del buffer de entrada media " << mean << ", máxima " << samples.max << "\n";
+        };
+        for (size_t s = 0; s < STAGES.size(); ++s) {
+            // La etapa está activa desde que alguno de sus trabajadores tomó el primer ítem hasta que
+            // el último entregó su último ítem
+            uint64_t total = 0, first_ns = UINT64_MAX, last_ns = 0;
+            for (const StageTally& tally : stage_tallies[s]) {
+                total += tally.processed;
+                if (tally.processed > 0) {
+                    first_ns = min(first_ns, tally.first_ns);
+                    last_ns = max(last_ns, tally.last_ns);
+                }
+            }
+            double seconds = total == 0 ? 0.0 : (last_ns - first_ns) / 1e9;
+            ss.precision(3);
+            ss << "Etapa " << STAGES[s].name << " (" << STAGES[s].workers << " trabajadores): " << total << " ítems en "
+               << seconds << " s activa (" << static_cast<uint64_t>(seconds > 0 ? total / seconds : 0) << " ítems/s), ";
+            showDepth(depths[s]);
+        }
+        ss << "Consumidores (" << NC << "): ";
+        showDepth(depths.back());
+        printMessage(ss.str()); // Llama a la función para imprimir y escribir en el archivo
+    }
+
+    // Suma los contadores de productores y de consumidores y los muestra junto con un diagnóstico:
+    // si los productores pasan más tiempo esperando espacio que los consumidores esperando ítems, los
+    // consumidores son el cuello de botella (y al revés); si el candado del buffer estuvo tomado la
+    // mayor parte del tiempo, lo es la contención por el propio buffer
+    void showMetrics(uint64_t elapsed_ns) {
+        ThreadMetrics produced, consumed;
+        for (const ThreadMetrics& metrics : producer_metrics) {
+            produced += metrics;
+        }
+        for (const ThreadMetrics& metrics : consumer_metrics) {
+            consumed += metrics;
+        }
+        // Fracción del tiempo de la corrida que cada grupo pasó esperando, en promedio por integrante
+        auto blockedShare = [&](const ThreadMetrics& total, int members) {
+            return elapsed_ns == 0 ? 0.0 : static_cast<double>(total.blocked_ns) / (static_cast<double>(elapsed_ns) * members);
+        };
+        double producers_blocked = blockedShare(produced, NP);
+        double consumers_blocked = blockedShare(consumed, NC);
+        double lock_share = elapsed_ns == 0 ? 0.0 : static_cast<double>(produced.lock_held_ns + consumed.lock_held_ns) / elapsed_ns;
+
+        std::stringstream ss;  // Crear un stringstream para construir el mensaje (con decimales)
+        ss.setf(ios::fixed);
+        ss.precision(1);
+        auto showGroup = [&](const char* name, int members, uint64_t items, const ThreadMetrics& total, double blocked) {
+            ss << name << " (" << members << "): " << items << " ítems, " << total.waits << " esperas bloqueadas, " << total.timeouts
+               << " plazos vencidos, " << total.blocked_ns / 1e6 << " ms esperando (" << blocked * 100
+               << "% del tiempo), " << total.lock_held_ns / 1e6 << " ms con el candado del buffer\n";
+        };
+        showGroup("Productores", NP, produced.produced, produced, producers_blocked);
+        showGroup("Consumidores", NC, consumed.consumed, consumed, consumers_blocked);
+        ss << "Diagnóstico: ";
+        if (lock_share > 0.5) {
+            ss << "limitado por la contención del buffer (el candado estuvo tomado el " << lock_share * 100 << "% del tiempo)\n";
+        } else if (producers_blocked < 0.05 && consumers_blocked < 0.05) {
+            ss << "sin cuello de botella en el buffer (casi no hubo esperas)\n";
+        } else if (producers_blocked > consumers_blocked) {
+            ss << "limitado por los consumidores (los productores esperaron espacio)\n";
+        } else {
+            ss << "limitado por los productores (los consumidores esperaron ítems)\n";
+        }
+        printMessage(ss.str()); // Llama a la función para imprimir y escribir en el archivo
+    }
+
+    // Hilos del ejecutor o del planificador de corrutinas
+    static unsigned executorThreads() {
+        return EXECUTOR_THREADS > 0 ? EXECUTOR_THREADS : max(1u, thread::hardware_concurrency());
+    }
+
+    // Combina los histogramas de los consumidores y muestra los percentiles de latencia
+    void showLatencies() {
+        LatencyHistogram total;
+        for (const auto& latency : latencies) {
+            total.merge(latency);
+        }
+        MessageBuilder message;  // Construir el mensaje sin memoria dinámica
+        message << "Latencia en el buffer (ns) de " << total.count() << " ítems: p50=" << total.percentile(50)
+                << " p90=" << total.percentile(90) << " p99=" << total.percentile(99)
+                << " p99.9=" << total.percentile(99.9) << " max=" << total.maxValue() << "\n";
+        printMessage(message.view()); // Llama a la función para imprimir y escribir en el archivo
     }
 };
 
 // Función principal
 int main(int argc, char* argv[]) {
     // Verifica que se proporcionen los parámetros correctos
-    if (argc != 5) {
-        cout << "Uso: " << argv[0] << " <capacidad del buffer> <número de ítems> <número de productores> <número de consumidores>" << endl;
+    if (argc < 5) {
+        cout << "Uso: " << argv[0] << " <capacidad del buffer> <número de ítems> <número de productores> <número de consumidores> [opciones]" << endl;
+        cout << "Opciones:" << endl;
+        cout << "  --buffer=auto|semaforo|mpmc|spsc|carriles  Implementación del buffer (por defecto: auto)" << endl;
+        cout << "  --carriles=<L>                     Carriles del modo carriles (por defecto: uno por productor)" << endl;
+        cout << "  --espera=giro|ceder|adaptativa|bloqueo  Espera con el buffer lleno o vacío (por defecto: adaptativa)" << endl;
+        cout << "  --desborde=bloquear|fallar|descartar-nuevo|descartar-antiguo|muestreo  Qué hace un productor con el buffer lleno (por defecto: bloquear)" << endl;
+        cout << "  --muestreo=<K>                     Con --desborde=muestreo conserva 1 de cada K ítems (por defecto: 4)" << endl;
+        cout << "  --etapa=<nombre>:<trabajadores>[:<carga>]  Etapa intermedia del pipeline entre productores y consumidores (repetible)" << endl;
+        cout << "  --etapas=<archivo>                 Etapas leídas de un archivo, una por línea con el formato de --etapa" << endl;
+        cout << "  --log=texto|binario                Formato del archivo de log (por defecto: texto)" << endl;
+        cout << "  --lote=<K>                         Ítems por lote de productores y consumidores, 1 a " << MAX_BATCH << " (por defecto: 1)" << endl;
+        cout << "  --ejecutor[=<H>]                   Productores y consumidores como tareas sobre H hilos (por defecto: núcleos)" << endl;
+        cout << "  --corrutinas[=<H>]                 Productores y consumidores como corrutinas sobre H hilos (por defecto: núcleos)" << endl;
+        cout << "  --simulacion[=<S>]                 Simulación determinista en tiempo virtual con semilla S (por defecto: 0)" << endl;
+        cout << "  --robo=<K>                         Consumidores con deque local de K ítems y robo de trabajo (por defecto: sin robo)" << endl;
+        cout << "  --carga-productor=<carga>          Carga después de cada producción (por defecto: fijo:2000)" << endl;
+        cout << "  --carga-consumidor=<carga>         Carga después de cada consumo (por defecto: fijo:1500)" << endl;
+        cout << "      <carga>: cero | fijo:<ms> | poisson:<ms media> | rafaga:<ítems>,<ms> | cpu:<iteraciones>" << endl;
         return 1; // Retorna 1 si el número de argumentos es incorrecto
     }
 
+    // Procesa las opciones adicionales de la forma --clave=valor
+    for (int i = 5; i < argc; ++i) {
+        string option = argv[i];
+        if (option == "--buffer=auto") {
+            BUFFER_MODE = BufferMode::Automatico;
+        } else if (option == "--buffer=spsc") {
+            BUFFER_MODE = BufferMode::SPSC;
+        } else if (option == "--buffer=semaforo") {
+            BUFFER_MODE = BufferMode::Semaforo;
+        } else if (option == "--buffer=mpmc") {
+            BUFFER_MODE = BufferMode::MPMC;
+        } else if (option == "--buffer=carriles") {
+            BUFFER_MODE = BufferMode::Carriles;
+        } else if (option.rfind("--carriles=", 0) == 0) {
+            LANES = atoi(option.c_str() + 11);
+            if (LANES < 1) {
+                cerr << "La cantidad de carriles debe ser positiva.\n"; // Mensaje de error
+                return 1; // Retorna 1 si la cantidad de carriles no es válida
+            }
+        } else if (option == "--espera=giro") {
+            WAIT_STRATEGY = WaitStrategy::Giro;
+        } else if (option == "--espera=ceder") {
+            WAIT_STRATEGY = WaitStrategy::Ceder;
+        } else if (option == "--espera=adaptativa") {
+            WAIT_STRATEGY = WaitStrategy::Adaptativa;
+        } else if (option == "--espera=bloqueo") {
+            WAIT_STRATEGY = WaitStrategy::Bloqueo;
+        } else if (option == "--desborde=bloquear") {
+            OVERFLOW_POLICY = OverflowPolicy::Bloquear;
+        } else if (option == "--desborde=fallar") {
+            OVERFLOW_POLICY = OverflowPolicy::Fallar;
+        } else if (option == "--desborde=descartar-nuevo") {
+            OVERFLOW_POLICY = OverflowPolicy::DescartarNuevo;
+        } else if (option == "--desborde=descartar-antiguo") {
+            OVERFLOW_POLICY = OverflowPolicy::DescartarAntiguo;
+        } else if (option == "--desborde=muestreo") {
+            OVERFLOW_POLICY = OverflowPolicy::Muestreo;
+        } else if (option.rfind("--muestreo=", 0) == 0) {
+            SAMPLE_RATE = atoi(option.c_str() + 11);
+            if (SAMPLE_RATE < 1) {
+                cerr << "La tasa de muestreo debe ser positiva.\n"; // Mensaje de error
+                return 1; // Retorna 1 si la tasa de muestreo no es válida
+            }
+        } else if (option.rfind("--etapa=", 0) == 0) {
+            StageConfig stage;
+            if (!parseStage(option.substr(8), stage)) {
+                cerr << "Etapa no válida: " << option << "\n"; // Mensaje de error
+                return 1; // Retorna 1 si la etapa no es válida
+            }
+            STAGES.push_back(stage);
+        } else if (option.rfind("--etapas=", 0) == 0) {
+            string error;
+            if (!loadStages(option.substr(9), error)) {
+                cerr << error << "\n"; // Mensaje de error
+                return 1; // Retorna 1 si el archivo de etapas no es válido
+            }
+        } else if (option == "--log=texto") {
+            LOG_FORMAT = LogFormat::Texto;
+        } else if (option == "--log=binario") {
+            LOG_FORMAT = LogFormat::Binario;
+        } else if (option.rfind("--lote=", 0) == 0) {
+            BATCH_SIZE = atoi(option.c_str() + 7);
+            if (BATCH_SIZE < 1 || BATCH_SIZE > static_cast<int>(MAX_BATCH)) {
+                cerr << "El lote debe estar entre 1 y " << MAX_BATCH << ".\n"; // Mensaje de error
+                return 1; // Retorna 1 si el lote no es válido
+            }
+        } else if (option == "--ejecutor" || option == "--corrutinas") {
+            (option == "--ejecutor" ? USE_EXECUTOR : USE_COROUTINES) = true;
+        } else if (option.rfind("--ejecutor=", 0) == 0 || option.rfind("--corrutinas=", 0) == 0) {
+            bool executor = option[2] == 'e';
+            (executor ? USE_EXECUTOR : USE_COROUTINES) = true;
+            int threads = atoi(option.c_str() + (executor ? 11 : 13));
+            if (threads < 1) {
+                cerr << "La cantidad de hilos debe ser positiva.\n"; // Mensaje de error
+                return 1; // Retorna 1 si la cantidad de hilos no es válida
+            }
+            EXECUTOR_THREADS = threads;
+        } else if (option == "--simulacion") {
+            SIMULATE = true;
+        } else if (option.rfind("--simulacion=", 0) == 0) {
+            SIMULATE = true;
+            char* end = nullptr;
+            RANDOM_SEED = strtoull(option.c_str() + 13, &end, 10);
+            if (option.size() == 13 || *end != '\0') {
+                cerr << "La semilla debe ser un entero no negativo.\n"; // Mensaje de error
+                return 1; // Retorna 1 si la semilla no es válida
+            }
+        } else if (option.rfind("--robo=", 0) == 0) {
+            STEAL_BATCH = atoi(option.c_str() + 7);
+            if (STEAL_BATCH < 1 || STEAL_BATCH > static_cast<int>(MAX_BATCH)) {
+                cerr << "El lote de robo debe estar entre 1 y " << MAX_BATCH << ".\n"; // Mensaje de error
+                return 1; // Retorna 1 si el lote de robo no es válido
+            }
+        } else if (option.rfind("--carga-productor=", 0) == 0 || option.rfind("--carga-consumidor=", 0) == 0) {
+            Workload& workload = option[8] == 'p' ? PRODUCER_WORKLOAD : CONSUMER_WORKLOAD;
+            if (!Workload::parse(option.substr(option.find('=') + 1), workload)) {
+                cerr << "Carga no válida: " << option << "\n"; // Mensaje de error
+                return 1; // Retorna 1 si la carga no es válida
+            }
+        } else {
+            cerr << "Opción desconocida: " << option << "\n"; // Mensaje de error
+            return 1; // Retorna 1 si la opción no es válida
+        }
+    }
+
     // Convierte los argumentos de la línea de comandos a enteros
     int buffer_capacity = atoi(argv[1]);
     N = atoi(argv[2]);
@@ -236,8 +1529,44 @@ int main(int argc, char* argv[]) {
         return 1; // Retorna 1 si algún parámetro es no válido
     }
 
+    // El anillo SPSC solo es correcto con un productor y un consumidor (también en cada etapa)
+    bool single_workers = all_of(STAGES.begin(), STAGES.end(), [](const StageConfig& stage) { return stage.workers == 1; });
+    if (BUFFER_MODE == BufferMode::SPSC && (NP != 1 || NC != 1 || !single_workers)) {
+        cerr << "El modo spsc requiere exactamente un productor y un consumidor.\n"; // Mensaje de error
+        return 1;
+    }
+    if (BUFFER_MODE == BufferMode::SPSC && OVERFLOW_POLICY == OverflowPolicy::DescartarAntiguo) {
+        cerr << "El modo spsc no permite descartar el ítem más antiguo: solo el consumidor extrae del anillo.\n"; // Mensaje de error
+        return 1;
+    }
+    if ((USE_EXECUTOR || USE_COROUTINES) && (BATCH_SIZE > 1 || STEAL_BATCH > 0)) {
+        cerr << "El ejecutor y las corrutinas mueven un ítem por paso y no se pueden combinar con --lote ni --robo.\n"; // Mensaje de error
+        return 1;
+    }
+    if ((USE_EXECUTOR || USE_COROUTINES) && !STAGES.empty()) {
+        cerr << "Las etapas del pipeline usan un hilo por trabajador y no se pueden combinar con --ejecutor ni --corrutinas.\n"; // Mensaje de error
+        return 1;
+    }
+    if (SIMULATE && (USE_EXECUTOR || USE_COROUTINES || BATCH_SIZE > 1 || STEAL_BATCH > 0 || !STAGES.empty())) {
+        cerr << "La simulación ejecuta las tareas del ejecutor en un solo hilo y no se puede combinar con --ejecutor, --corrutinas, --lote, --robo ni --etapa.\n"; // Mensaje de error
+        return 1;
+    }
+    if (USE_EXECUTOR && USE_COROUTINES) {
+        cerr << "Elija solo una de las opciones --ejecutor y --corrutinas.\n"; // Mensaje de error
+        return 1;
+    }
+
+    // Abre el archivo de log en el formato elegido
+    if (LOG_FORMAT == LogFormat::Binario) {
+        logFile.open("producer-consumer.bin", ios::binary);
+    } else {
+        logFile.open("producer-consumer.txt");
+    }
+
+    logger.start(LOG_FORMAT); // Inicia el hilo que escribe los mensajes en consola y archivo
     Principal principal(buffer_capacity); // Crea una instancia de la clase Principal con la capacidad del buffer
     principal.run(); // Ejecuta el método run de la clase Principal
+    logger.stop(); // Espera a que se escriban todos los mensajes pendientes
 
     logFile.close();  // Cerrar el archivo de log
     return 0; // Retorna 0 para indicar que el programa terminó correctamente
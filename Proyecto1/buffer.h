@@ -0,0 +1,1966 @@
+// Buffer acotado de Proyecto1 y todo lo que necesita: anillos sin bloqueo, semáforo con cierre,
+// registro asíncrono e histograma de latencias. Lo comparten Proyecto1 y el benchmark de rendimiento.
+#pragma once
+
+#include <iostream>  // Librería para imprimir en consola
+#include <thread>    // Librería para usar hilos
+#include <semaphore> // Librería para usar semáforos
+#include <queue>     // Librería para usar colas (priority_queue del registro)
+#include <vector>    // Librería para usar vectores
+#include <chrono>    // Librería para manipular tiempo
+#include <mutex>     // Librería para usar mutex (para evitar condiciones de carrera)
+#include <condition_variable> // Librería para esperar con cancelación (condition_variable_any)
+#include <stop_token> // Librería para cancelar hilos (stop_token, jthread)
+#include <fstream>   // Librería para manejar archivos
+#include <sstream>   // Librería para construir cadenas de texto
+#include <atomic>    // Librería para operaciones atómicas (cola sin bloqueo)
+#include <memory>    // Librería para punteros inteligentes
+#include <new>       // Librería para construir objetos en memoria ya reservada (launder)
+#include <optional>  // Librería para valores opcionales (resultado de consumir)
+#include <deque>     // Librería para colas de doble extremo (almacenamiento del modo Semaforo)
+#include <string>    // Librería para manejar cadenas de texto
+#include <string_view> // Librería para pasar mensajes sin copiarlos
+#include <cstring>   // Librería para copiar memoria (memcpy)
+#include <algorithm> // Librería para algoritmos (min, max)
+#include <array>     // Librería para arreglos de tamaño fijo
+#include <bit>       // Librería para operaciones de bits (countl_zero)
+#include <span>      // Librería para vistas de arreglos (lotes de ítems)
+#include <utility>   // Librería para intercambiar valores (exchange)
+#include <type_traits> // Librería para consultar propiedades de tipos (is_trivially_copyable)
+#include <functional> // Librería para calcular hashes (hash<thread::id>)
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h> // Instrucción de pausa para giros activos (_mm_pause)
+#endif
+
+#include "eventos.h" // Tipos de evento, formato del log binario y construcción de mensajes
+
+using namespace std;
+
+// Variables globales para configuración del buffer
+// Distancia mínima entre datos que escriben hilos distintos para que no compartan línea de caché
+#ifdef __cpp_lib_hardware_interference_size
+// GCC advierte cuando este valor se usa en un encabezado porque puede cambiar entre opciones de
+// compilación; aquí no forma parte de ninguna interfaz entre binarios
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+inline const size_t CACHE_LINE_SIZE = hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+inline const size_t CACHE_LINE_SIZE = 64;  // Tamaño de línea de caché habitual cuando la librería no lo informa
+#endif
+inline const size_t MAX_BATCH = 64;  // Máximo de ítems que se mueven por cada sincronización con el buffer
+
+// Implementaciones disponibles para el almacenamiento del buffer
+enum class BufferMode {
+    Semaforo,  // Cola std::queue protegida por un semáforo binario (implementación original)
+    MPMC,      // Anillo acotado sin bloqueo con números de secuencia por celda (estilo Vyukov)
+    SPSC,      // Anillo de un solo productor y un solo consumidor, sin semáforos
+    Carriles,  // Un anillo MPMC por productor (o grupo de productores); los consumidores recorren los carriles
+    Automatico // SPSC cuando hay un productor y un consumidor, Semaforo en otro caso
+};
+inline BufferMode BUFFER_MODE = BufferMode::Automatico;  // Modo elegido con la opción --buffer=<modo>
+
+// Estrategias de espera cuando el buffer está lleno o vacío
+enum class WaitStrategy {
+    Giro,       // Giro activo sin ceder nunca el núcleo (latencia mínima, un núcleo ocupado por hilo en espera)
+    Ceder,      // Giro breve y luego this_thread::yield() en bucle, sin dormir
+    Adaptativa, // Giro de duración adaptativa y luego dormir (en el semáforo, sobre un futex)
+    Bloqueo     // Dormir de inmediato (comportamiento original del semáforo)
+};
+inline WaitStrategy WAIT_STRATEGY = WaitStrategy::Adaptativa;  // Estrategia elegida con --espera=<estrategia>
+
+// Políticas de desborde: qué hace produce() cuando el buffer está lleno
+enum class OverflowPolicy {
+    Bloquear,          // Esperar hasta que haya espacio (comportamiento original)
+    Fallar,            // Rechazar el ítem de inmediato y avisar al productor
+    DescartarNuevo,    // Descartar el ítem que se quería insertar
+    DescartarAntiguo,  // Descartar el ítem más antiguo del buffer para dejar lugar al nuevo
+    Muestreo           // Conservar uno de cada SAMPLE_RATE ítems (esperando espacio) y descartar el resto
+};
+inline OverflowPolicy OVERFLOW_POLICY = OverflowPolicy::Bloquear;  // Política elegida con --desborde=<política>
+inline int SAMPLE_RATE = 4;  // Con --desborde=muestreo, se conserva 1 de cada SAMPLE_RATE ítems que encuentran el buffer lleno (--muestreo=<K>)
+
+// Formatos disponibles para el archivo de log
+enum class LogFormat {
+    Texto,   // producer-consumer.txt con los mismos mensajes que la consola
+    Binario  // producer-consumer.bin con registros compactos (ver BinaryLogEncoder)
+};
+inline LogFormat LOG_FORMAT = LogFormat::Texto;  // Formato elegido con la opción --log=<formato>
+
+// Archivo de salida para guardar los datos (se abre en main según el formato)
+inline ofstream logFile;
+
+inline const auto PROGRAM_START = chrono::steady_clock::now();  // Referencia para las marcas de tiempo del log
+
+// Reloj virtual de la simulación de eventos discretos: mientras VIRTUAL_TIME está activo,
+// elapsedNanoseconds() retorna VIRTUAL_NOW_NS en lugar del tiempo real. Solo los modifica el único
+// hilo que ejecuta la simulación
+inline bool VIRTUAL_TIME = false;
+inline uint64_t VIRTUAL_NOW_NS = 0;
+
+// Nanosegundos transcurridos desde el inicio del programa (o desde el inicio de la simulación)
+inline uint64_t elapsedNanoseconds() {
+    if (VIRTUAL_TIME) {
+        return VIRTUAL_NOW_NS;
+    }
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - PROGRAM_START).count();
+}
+
+// Espacio sin inicializar donde se construye un ítem en el lugar (permite tipos sin constructor por
+// defecto y tipos que solo se pueden mover)
+template <typename T>
+struct ItemStorage {
+    alignas(T) unsigned char bytes[sizeof(T)];
+
+    // Ítem construido en este espacio
+    T* get() {
+        return launder(reinterpret_cast<T*>(bytes));
+    }
+    const T* get() const {
+        return launder(reinterpret_cast<const T*>(bytes));
+    }
+};
+
+// Cola circular acotada para varios productores y varios consumidores, sin bloqueo (algoritmo de Vyukov).
+// Cada celda guarda un número de secuencia que indica si está libre para el productor de la vuelta
+// actual o lista para el consumidor, de modo que productores y consumidores solo compiten con un CAS
+// sobre su propio índice y nunca toman un candado global.
+template <typename T>
+class MPMCRing {
+private:
+    struct Cell {
+        atomic<size_t> sequence;  // Número de secuencia que indica el estado de la celda
+        ItemStorage<T> data;      // Ítem almacenado en la celda
+    };
+
+    unique_ptr<Cell[]> cells;  // Arreglo de celdas (tamaño potencia de dos)
+    size_t mask;               // Máscara para calcular el índice de la celda (tamaño - 1)
+    size_t capacity;           // Capacidad lógica (puede ser menor que la cantidad de celdas)
+    alignas(CACHE_LINE_SIZE) atomic<size_t> enqueue_pos{0};  // Próxima posición a escribir (productores)
+    alignas(CACHE_LINE_SIZE) atomic<size_t> dequeue_pos{0};  // Próxima posición a leer (consumidores)
+
+public:
+    // Constructor que reserva celdas para la siguiente potencia de dos (al menos dos), pero el anillo
+    // nunca guarda más de `capacity` ítems
+    explicit MPMCRing(size_t capacity) : capacity(capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;  // Duplicar hasta alcanzar la capacidad pedida
+        }
+        cells = make_unique<Cell[]>(size);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, memory_order_relaxed);  // Cada celda comienza libre para la vuelta 0
+        }
+    }
+
+    // Destruye los ítems que no se consumieron
+    ~MPMCRing() {
+        forEach([](const T& item) { item.~T(); });
+    }
+
+    MPMCRing(const MPMCRing&) = delete;
+    MPMCRing& operator=(const MPMCRing&) = delete;
+
+    // Reserva la próxima celda libre para construir un ítem en el lugar con storage(pos); retorna la
+    // posición o un valor vacío si el anillo está lleno. Los consumidores no ven la celda hasta publish(pos)
+    optional<size_t> tryClaim() {
+        size_t pos = enqueue_pos.load(memory_order_relaxed);
+        while (true) {
+            size_t seq = cells[pos & mask].sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {  // La celda está libre para esta vuelta: intentar reservarla
+                // Con más celdas que capacidad, revisar también la capacidad lógica. El índice de lectura
+                // puede estar atrasado, lo que a lo sumo informa lleno de más; se lee solo en ese caso
+                // para no llevar la línea de los consumidores a los productores cuando no hace falta
+                if (capacity <= mask &&
+                    static_cast<intptr_t>(pos - dequeue_pos.load(memory_order_acquire)) >= static_cast<intptr_t>(capacity)) {
+                    return nullopt;
+                }
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    return pos;
+                }
+            } else if (diff < 0) {  // La celda aún no ha sido consumida: anillo lleno
+                return nullopt;
+            } else {  // Otro productor reservó la posición: releer el índice
+                pos = enqueue_pos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // Publica para los consumidores el ítem construido en una celda reservada con tryClaim()
+    void publish(size_t pos) {
+        cells[pos & mask].sequence.store(pos + 1, memory_order_release);
+    }
+
+    // Reserva la próxima celda publicada para usar su ítem en el lugar con storage(pos); retorna la
+    // posición o un valor vacío si el anillo está vacío. La celda no se reutiliza hasta release(pos)
+    optional<size_t> tryPeek() {
+        size_t pos = dequeue_pos.load(memory_order_relaxed);
+        while (true) {
+            size_t seq = cells[pos & mask].sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {  // La celda contiene un ítem publicado: intentar reservarla
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    return pos;
+                }
+            } else if (diff < 0) {  // La celda aún no ha sido publicada: anillo vacío
+                return nullopt;
+            } else {  // Otro consumidor tomó la posición: releer el índice
+                pos = dequeue_pos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // Destruye el ítem de una celda reservada con tryPeek() y la libera para la siguiente vuelta
+    void release(size_t pos) {
+        Cell& cell = cells[pos & mask];
+        cell.data.get()->~T();
+        cell.sequence.store(pos + mask + 1, memory_order_release);
+    }
+
+    // Memoria de la celda de una posición reservada con tryClaim() o tryPeek()
+    ItemStorage<T>& storage(size_t pos) {
+        return cells[pos & mask].data;
+    }
+
+    // Intenta construir un ítem con `args` directamente en una celda libre; retorna false si el anillo
+    // está lleno (en ese caso `args` no se usan). `inspect` recibe el ítem ya construido antes de publicarlo
+    template <typename Inspect, typename... Args>
+    bool tryEmplaceInspect(Inspect&& inspect, Args&&... args) {
+        optional<size_t> pos = tryClaim();
+        if (!pos) {
+            return false;
+        }
+        inspect(*new (storage(*pos).bytes) T(forward<Args>(args)...));
+        publish(*pos);
+        return true;
+    }
+
+    // Intenta construir un ítem en el lugar; retorna false si el anillo está lleno
+    template <typename... Args>
+    bool tryEmplace(Args&&... args) {
+        return tryEmplaceInspect([](const T&) {}, forward<Args>(args)...);
+    }
+
+    // Intenta insertar (copiando o moviendo) un ítem; retorna false si el anillo está lleno
+    template <typename U>
+    bool tryPush(U&& item) {
+        return tryEmplace(forward<U>(item));
+    }
+
+    // Intenta extraer (moviendo) un ítem; retorna un valor vacío si el anillo está vacío
+    optional<T> tryPop() {
+        optional<size_t> pos = tryPeek();
+        if (!pos) {
+            return nullopt;
+        }
+        optional<T> item(std::move(*storage(*pos).get()));
+        release(*pos);
+        return item;
+    }
+
+    // Cantidad aproximada de ítems en el anillo (exacta si no hay operaciones en curso)
+    size_t size() const {
+        size_t head = dequeue_pos.load(memory_order_relaxed);  // Leer primero la lectura para no obtener un valor negativo
+        return enqueue_pos.load(memory_order_relaxed) - head;
+    }
+
+    // Recorre los ítems pendientes en orden; solo es válido cuando no hay hilos operando sobre el anillo
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (size_t pos = dequeue_pos.load(); pos != enqueue_pos.load(); ++pos) {
+            visit(*cells[pos & mask].data.get());
+        }
+    }
+};
+
+// Cola circular acotada para exactamente un productor y un consumidor.
+// Cada lado escribe solo su propio índice y guarda una copia del índice del otro lado, que
+// se relee únicamente cuando la copia indica lleno o vacío; los dos lados viven en líneas de
+// caché distintas para que no se invaliden mutuamente en cada operación.
+template <typename T>
+class SPSCRing {
+private:
+    // Estado escrito por el productor
+    struct alignas(CACHE_LINE_SIZE) ProducerSide {
+        atomic<size_t> tail{0};  // Próxima posición a escribir
+        size_t cached_head = 0;  // Última posición de lectura observada por el productor
+    };
+
+    // Estado escrito por el consumidor
+    struct alignas(CACHE_LINE_SIZE) ConsumerSide {
+        atomic<size_t> head{0};  // Próxima posición a leer
+        size_t cached_tail = 0;  // Última posición de escritura observada por el consumidor
+    };
+
+    unique_ptr<ItemStorage<T>[]> slots;  // Arreglo de posiciones (tamaño potencia de dos)
+    size_t mask;              // Máscara para calcular el índice (tamaño - 1)
+    size_t capacity;          // Capacidad lógica del buffer
+    ProducerSide producer;
+    ConsumerSide consumer;
+
+public:
+    // Constructor que reserva la siguiente potencia de dos y respeta la capacidad pedida
+    explicit SPSCRing(size_t capacity) : capacity(capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;  // Duplicar hasta alcanzar la capacidad pedida
+        }
+        slots = make_unique<ItemStorage<T>[]>(size);
+        mask = size - 1;
+    }
+
+    // Destruye los ítems que no se consumieron
+    ~SPSCRing() {
+        forEach([](const T& item) { item.~T(); });
+    }
+
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    // Reserva la próxima posición libre para construir un ítem en el lugar con storage(pos); solo
+    // puede llamarlo el único productor. Retorna un valor vacío si el anillo está lleno
+    optional<size_t> tryClaim() {
+        if (full()) {
+            return nullopt;
+        }
+        return producer.tail.load(memory_order_relaxed);
+    }
+
+    // Publica el ítem construido en la posición reservada con tryClaim()
+    void publish(size_t pos) {
+        producer.tail.store(pos + 1, memory_order_release);
+    }
+
+    // Reserva el próximo ítem publicado para usarlo en el lugar con storage(pos); solo puede llamarlo
+    // el único consumidor. Retorna un valor vacío si el anillo está vacío
+    optional<size_t> tryPeek() {
+        size_t head = consumer.head.load(memory_order_relaxed);
+        if (head == consumer.cached_tail) {
+            consumer.cached_tail = producer.tail.load(memory_order_acquire);  // Refrescar la copia solo si parece vacío
+            if (head == consumer.cached_tail) {
+                return nullopt;
+            }
+        }
+        return head;
+    }
+
+    // Destruye el ítem de la posición reservada con tryPeek() y la libera para el productor
+    void release(size_t pos) {
+        slots[pos & mask].get()->~T();
+        consumer.head.store(pos + 1, memory_order_release);
+    }
+
+    // Memoria de una posición reservada con tryClaim() o tryPeek()
+    ItemStorage<T>& storage(size_t pos) {
+        return slots[pos & mask];
+    }
+
+    // Intenta construir un ítem en el lugar; solo puede llamarlo el único productor.
+    // `inspect` recibe el ítem ya construido antes de publicarlo
+    template <typename Inspect, typename... Args>
+    bool tryEmplaceInspect(Inspect&& inspect, Args&&... args) {
+        optional<size_t> pos = tryClaim();
+        if (!pos) {
+            return false;
+        }
+        inspect(*new (storage(*pos).bytes) T(forward<Args>(args)...));
+        publish(*pos);
+        return true;
+    }
+
+    // Intenta construir un ítem en el lugar; retorna false si el anillo está lleno
+    template <typename... Args>
+    bool tryEmplace(Args&&... args) {
+        return tryEmplaceInspect([](const T&) {}, forward<Args>(args)...);
+    }
+
+    // Intenta insertar (copiando o moviendo) un ítem; retorna false si el anillo está lleno
+    template <typename U>
+    bool tryPush(U&& item) {
+        return tryEmplace(forward<U>(item));
+    }
+
+    // Intenta extraer (moviendo) un ítem; solo puede llamarlo el único consumidor
+    optional<T> tryPop() {
+        optional<size_t> pos = tryPeek();
+        if (!pos) {
+            return nullopt;
+        }
+        optional<T> item(std::move(*storage(*pos).get()));
+        release(*pos);
+        return item;
+    }
+
+    // Indica si el anillo está lleno; solo el productor obtiene una respuesta estable
+    bool full() {
+        size_t tail = producer.tail.load(memory_order_relaxed);
+        if (tail - producer.cached_head == capacity) {
+            producer.cached_head = consumer.head.load(memory_order_acquire);  // Refrescar la copia solo si parece lleno
+        }
+        return tail - producer.cached_head == capacity;
+    }
+
+    // Posiciones libres; solo el productor obtiene una cota inferior estable
+    size_t freeSpace() {
+        producer.cached_head = consumer.head.load(memory_order_acquire);
+        return capacity - (producer.tail.load(memory_order_relaxed) - producer.cached_head);
+    }
+
+    // Cantidad aproximada de ítems en el anillo (exacta si no hay operaciones en curso)
+    size_t size() const {
+        size_t head = consumer.head.load(memory_order_relaxed);  // Leer primero la lectura para no obtener un valor negativo
+        return producer.tail.load(memory_order_relaxed) - head;
+    }
+
+    // Recorre los ítems pendientes en orden; solo es válido cuando no hay hilos operando sobre el anillo
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (size_t pos = consumer.head.load(); pos != producer.tail.load(); ++pos) {
+            visit(*slots[pos & mask].get());
+        }
+    }
+};
+
+// Deque de robo de trabajo de capacidad fija (algoritmo de Chase y Lev).
+// Solo el dueño inserta y extrae por el extremo inferior, sin CAS salvo cuando compite por el
+// último ítem; los demás hilos roban el ítem más antiguo por el extremo superior con un CAS.
+// Los ítems se leen antes de confirmar el robo, por lo que deben ser trivialmente copiables.
+template <typename T>
+class WorkStealingDeque {
+    static_assert(is_trivially_copyable_v<T>, "El deque de robo copia los ítems de forma atómica");
+
+private:
+    unique_ptr<atomic<T>[]> items;  // Arreglo circular (tamaño potencia de dos)
+    size_t mask;                    // Máscara para calcular el índice (tamaño - 1)
+    alignas(CACHE_LINE_SIZE) atomic<int64_t> top{0};     // Próximo ítem a robar (ladrones)
+    alignas(CACHE_LINE_SIZE) atomic<int64_t> bottom{0};  // Próxima posición a escribir (dueño)
+
+public:
+    // Constructor que redondea la capacidad a la siguiente potencia de dos
+    explicit WorkStealingDeque(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;  // Duplicar hasta alcanzar la capacidad pedida
+        }
+        items = make_unique<atomic<T>[]>(size);
+        mask = size - 1;
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Inserta un ítem por abajo; solo puede llamarlo el dueño. Retorna false si el deque está lleno
+    bool push(T item) {
+        int64_t b = bottom.load(memory_order_relaxed);
+        int64_t t = top.load(memory_order_acquire);
+        if (b - t > static_cast<int64_t>(mask)) {
+            return false;
+        }
+        items[b & mask].store(item, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);  // El ítem es visible antes que el nuevo extremo
+        bottom.store(b + 1, memory_order_relaxed);
+        return true;
+    }
+
+    // Extrae el ítem más reciente; solo puede llamarlo el dueño
+    optional<T> pop() {
+        int64_t b = bottom.load(memory_order_relaxed) - 1;
+        bottom.store(b, memory_order_relaxed);  // Reservar el ítem antes de mirar a los ladrones
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t t = top.load(memory_order_relaxed);
+        if (t > b) {  // Vacío
+            bottom.store(b + 1, memory_order_relaxed);
+            return nullopt;
+        }
+        T item = items[b & mask].load(memory_order_relaxed);
+        if (t == b) {  // Último ítem: se lo disputa con los ladrones
+            bool won = top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+            bottom.store(b + 1, memory_order_relaxed);
+            return won ? optional<T>(item) : nullopt;
+        }
+        return item;
+    }
+
+    // Roba el ítem más antiguo; la puede llamar cualquier hilo. Retorna un valor vacío si el deque
+    // está vacío o si otro hilo tomó el ítem primero
+    optional<T> steal() {
+        int64_t t = top.load(memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t b = bottom.load(memory_order_acquire);
+        if (t >= b) {
+            return nullopt;
+        }
+        T item = items[t & mask].load(memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+            return nullopt;
+        }
+        return item;
+    }
+};
+
+// Pausa breve dentro de un giro activo: avisa al procesador que el hilo está esperando, lo que
+// reduce el consumo y deja recursos al otro hilo del mismo núcleo
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Contadores de un productor o consumidor. Solo los escribe el hilo que lo ejecuta, así que son
+// enteros simples; cada uno ocupa su propia línea de caché para que los hilos no se invaliden
+// entre sí al contar. Se suman al final de la corrida
+struct alignas(CACHE_LINE_SIZE) ThreadMetrics {
+    uint64_t produced = 0;      // Ítems insertados en el buffer
+    uint64_t consumed = 0;      // Ítems consumidos
+    uint64_t waits = 0;         // Veces que quedó esperando con el buffer lleno o vacío (el reintento inmediato no bastó)
+    uint64_t timeouts = 0;      // Esperas que terminaron porque venció el plazo
+    uint64_t blocked_ns = 0;    // Tiempo total esperando
+    uint64_t lock_held_ns = 0;  // Tiempo total con el candado del buffer tomado (modo Semaforo)
+
+    ThreadMetrics& operator+=(const ThreadMetrics& other) {
+        produced += other.produced;
+        consumed += other.consumed;
+        waits += other.waits;
+        timeouts += other.timeouts;
+        blocked_ns += other.blocked_ns;
+        lock_held_ns += other.lock_held_ns;
+        return *this;
+    }
+};
+
+// Métricas del productor o consumidor que se está ejecutando en este hilo; nulo si no se miden
+// (por ejemplo en el benchmark), y entonces no se registra nada
+inline thread_local ThreadMetrics* CURRENT_METRICS = nullptr;
+
+// Mide una espera en las métricas del hilo actual. La espera empieza con start(), que se puede
+// llamar recién cuando el primer intento falla, y se registra al destruir el objeto
+class WaitMeter {
+private:
+    ThreadMetrics* metrics = CURRENT_METRICS;
+    uint64_t start_ns = 0;    // Inicio de la espera
+    bool started = false;     // Indica que hubo espera
+    bool timed_out = false;   // Indica que la espera terminó por el plazo
+
+public:
+    WaitMeter() = default;
+    WaitMeter(const WaitMeter&) = delete;
+    WaitMeter& operator=(const WaitMeter&) = delete;
+
+    void start() {
+        if (metrics && !started) {
+            started = true;
+            start_ns = elapsedNanoseconds();
+        }
+    }
+
+    void timeout() {
+        timed_out = true;
+    }
+
+    ~WaitMeter() {
+        if (started) {
+            metrics->waits++;
+            metrics->blocked_ns += elapsedNanoseconds() - start_ns;
+            if (timed_out) {
+                metrics->timeouts++;
+            }
+        }
+    }
+};
+
+// Candado binario que además mide cuánto tiempo lo mantiene tomado cada hilo. Tiene la misma
+// interfaz que el counting_semaphore<1> al que reemplaza
+class TimedLock {
+private:
+    counting_semaphore<1> lock{1};  // Candado propiamente tal
+    uint64_t acquired_ns = 0;       // Momento en que se tomó (solo lo usa quien lo tiene)
+
+public:
+    void acquire() {
+        lock.acquire();
+        if (CURRENT_METRICS) {
+            acquired_ns = elapsedNanoseconds();
+        }
+    }
+
+    void release() {
+        if (CURRENT_METRICS) {
+            CURRENT_METRICS->lock_held_ns += elapsedNanoseconds() - acquired_ns;
+        }
+        lock.release();
+    }
+};
+
+// Límite de vueltas de giro de la estrategia adaptativa, compartido por los hilos que esperan lo
+// mismo (un permiso de un semáforo, o espacio o ítems en un anillo). Crece cuando el giro consigue
+// lo esperado y se reduce cuando igual hay que dormir, así los hilos solo giran mientras suele valer la pena
+class AdaptiveSpin {
+private:
+    static constexpr int MIN_SPIN = 16;    // Vueltas mínimas de giro
+    static constexpr int MAX_SPIN = 4096;  // Vueltas máximas de giro
+
+    atomic<int> spin_limit{256};  // Vueltas de giro antes de dormir
+
+public:
+    // Vueltas que conviene girar en la próxima espera
+    int current() const {
+        return spin_limit.load(memory_order_relaxed);
+    }
+
+    // El giro de `limit` vueltas (leídas con current()) consiguió lo esperado: girar algo más la próxima vez
+    void succeeded(int limit) {
+        spin_limit.store(min(MAX_SPIN, limit + limit / 8 + 1), memory_order_relaxed);
+    }
+
+    // Después de girar `limit` vueltas igual hubo que dormir: girar menos la próxima vez
+    void failed(int limit) {
+        spin_limit.store(max(MIN_SPIN, limit - limit / 4), memory_order_relaxed);
+    }
+};
+
+// Reintenta una operación sin bloqueo hasta que tenga éxito o se cumpla el plazo, esperando entre
+// intentos según la estrategia: Giro solo gira, Ceder gira brevemente y luego cede el procesador,
+// Adaptativa gira, cede y finalmente duerme intervalos cortos (rápida con el buffer activo sin
+// consumir un núcleo cuando está inactivo) y Bloqueo duerme desde el primer fallo. Como la
+// operación no tiene a quién esperar, dormir es volver a intentar cada 50 µs. Con Adaptativa,
+// la fase de giro dura las vueltas que indique `adaptive` (o 64 sin él) y lo ajusta según el resultado
+inline const auto NO_DEADLINE = chrono::steady_clock::time_point::max();  // Plazo que nunca vence
+
+template <typename Operation>
+bool retryUntil(Operation operation, chrono::steady_clock::time_point deadline, WaitStrategy strategy = WAIT_STRATEGY,
+                AdaptiveSpin* adaptive = nullptr) {
+    WaitMeter meter;
+    if (strategy != WaitStrategy::Adaptativa) {
+        adaptive = nullptr;  // Las demás estrategias giran siempre lo mismo
+    }
+    int spin_limit = adaptive != nullptr ? adaptive->current() : 64;
+    for (int attempt = 0;; ++attempt) {
+        if (operation()) {
+            if (adaptive != nullptr && attempt > 0 && attempt <= spin_limit) {
+                adaptive->succeeded(spin_limit);  // El giro bastó
+            }
+            return true;
+        }
+        if (adaptive != nullptr && attempt == spin_limit) {
+            adaptive->failed(spin_limit);  // El giro no bastó: sigue cediendo y durmiendo
+        }
+        meter.start();  // Solo cuenta como espera si el primer intento falla
+        bool spin = strategy == WaitStrategy::Giro || (strategy != WaitStrategy::Bloqueo && attempt < spin_limit);
+        bool yield = !spin && (strategy == WaitStrategy::Ceder || (strategy == WaitStrategy::Adaptativa && attempt < spin_limit + 64));
+        if ((spin || yield) && (attempt % 64 != 63 || deadline == NO_DEADLINE)) {
+            if (spin) {
+                cpuRelax();  // Giro activo
+            } else {
+                this_thread::yield();  // Ceder el procesador
+            }
+            continue;
+        }
+        if (chrono::steady_clock::now() >= deadline) {
+            meter.timeout();
+            return false;
+        }
+        if (!spin && !yield) {
+            this_thread::sleep_for(chrono::microseconds(50));  // Dormir un intervalo corto
+        }
+    }
+}
+
+// Registro asíncrono de mensajes.
+// Cada hilo escribe sus mensajes en su propio anillo SPSC (sin candados) y un hilo escritor
+// dedicado los vacía hacia la consola y el archivo. Cada mensaje lleva un número de secuencia
+// global y el escritor los emite estrictamente en ese orden, así la salida conserva el orden
+// en que ocurrieron los eventos aunque provengan de anillos distintos.
+// Los eventos viajan como EventRecord y el escritor los convierte a texto o los guarda en
+// formato binario, de modo que los hilos de trabajo no formatean nada.
+class AsyncLogger {
+private:
+    static constexpr size_t RECORD_TEXT_SIZE = MESSAGE_CAPACITY;  // Bytes de texto por registro (registro de 256 bytes)
+    static constexpr size_t CHANNEL_CAPACITY = 256;   // Registros que puede acumular cada hilo
+    static constexpr size_t BINARY_FLUSH_SIZE = 1 << 20;  // Bytes de log binario acumulados antes de escribir
+
+    // Evento o fragmento de texto de tamaño fijo; los textos largos ocupan varios registros consecutivos
+    struct Record {
+        uint64_t sequence = 0;  // Posición del registro en el orden global
+        EventRecord event;      // Evento (event.type es Texto cuando el registro lleva texto libre)
+        uint32_t length = 0;    // Bytes válidos en `text`
+        char text[RECORD_TEXT_SIZE];
+    };
+
+    // Anillo de registros de un hilo
+    struct Channel {
+        SPSCRing<Record> ring{CHANNEL_CAPACITY};
+    };
+
+    // Orden para que la cola de prioridad entregue primero la menor secuencia
+    struct LaterSequence {
+        bool operator()(const Record& a, const Record& b) const { return a.sequence > b.sequence; }
+    };
+
+    mutex registry_mutex;                 // Protege la lista de canales (solo al registrar un hilo nuevo)
+    vector<shared_ptr<Channel>> channels; // Canales de todos los hilos que han registrado mensajes
+    atomic<uint64_t> next_sequence{0};    // Próxima secuencia a asignar
+    atomic<bool> running{false};          // Indica si el hilo escritor debe seguir activo
+    LogFormat format = LogFormat::Texto;  // Formato del archivo de log
+    bool enabled = true;                  // Con false se descartan todos los mensajes (solo se cambia antes de crear hilos)
+    thread writer;                        // Hilo que escribe en consola y archivo
+
+    // Retorna el canal del hilo actual, creándolo y registrándolo la primera vez
+    Channel& localChannel() {
+        thread_local shared_ptr<Channel> channel;  // El registro conserva el canal aunque el hilo termine
+        if (!channel) {
+            channel = make_shared<Channel>();
+            lock_guard<mutex> lock(registry_mutex);
+            channels.push_back(channel);
+        }
+        return *channel;
+    }
+
+    // Copia un registro en el anillo del hilo actual
+    void push(const Record& record) {
+        Channel& channel = localChannel();
+        while (!channel.ring.tryPush(record)) {
+            this_thread::yield();  // Anillo lleno: dejar que el escritor avance
+        }
+    }
+
+    // Copia un fragmento de texto en el anillo del hilo actual
+    void pushText(uint64_t sequence, string_view text) {
+        Record record;
+        record.sequence = sequence;
+        record.event.type = EventType::Texto;
+        record.length = static_cast<uint32_t>(text.size());
+        memcpy(record.text, text.data(), text.size());
+        push(record);
+    }
+
+    // Bucle del hilo escritor: recoge registros de todos los canales y los emite en orden de secuencia
+    void writerLoop() {
+        priority_queue<Record, vector<Record>, LaterSequence> pending; // Registros recibidos fuera de orden
+        uint64_t next_to_write = 0;  // Secuencia que debe emitirse a continuación
+        string output;               // Texto acumulado en esta vuelta
+        string binary;               // Registros binarios pendientes de escribir en el archivo
+        BinaryLogEncoder encoder;    // Codifica los registros del log binario
+        vector<shared_ptr<Channel>> snapshot;
+        while (true) {
+            bool stopping = !running.load(memory_order_acquire);  // Leer antes de vaciar para no perder registros
+            {
+                lock_guard<mutex> lock(registry_mutex);
+                snapshot = channels;
+            }
+            for (auto& channel : snapshot) {
+                while (optional<Record> record = channel->ring.tryPop()) {
+                    pending.push(*record);
+                }
+            }
+            // Emitir solo los registros contiguos; al terminar se emite todo lo que quede
+            while (!pending.empty() && (stopping || pending.top().sequence == next_to_write)) {
+                const Record& top = pending.top();
+                if (top.event.type == EventType::Texto) {
+                    output.append(top.text, top.length);
+                    if (format == LogFormat::Binario) {
+                        encoder.text(binary, string_view(top.text, top.length));
+                    }
+                } else {
+                    MessageBuilder message;
+                    formatEvent(message, top.event);
+                    output.append(message.view());
+                    if (format == LogFormat::Binario) {
+                        encoder.event(binary, top.event);
+                    }
+                }
+                next_to_write = top.sequence + 1;
+                pending.pop();
+            }
+            if (binary.size() >= BINARY_FLUSH_SIZE || (stopping && !binary.empty())) {
+                logFile.write(binary.data(), binary.size());  // Escritura grande en el archivo binario
+                binary.clear();
+            }
+            if (!output.empty()) {
+                cout.write(output.data(), output.size());  // Imprimir en la consola
+                if (format == LogFormat::Texto) {
+                    logFile.write(output.data(), output.size());  // Escribir en el archivo
+                }
+                cout.flush();
+                output.clear();
+            } else if (stopping) {
+                break;
+            } else {
+                this_thread::sleep_for(chrono::microseconds(200));  // Nada nuevo: esperar un momento
+            }
+        }
+        logFile.flush();
+    }
+
+public:
+    // Inicia el hilo escritor; en formato binario escribe primero la cabecera del archivo
+    void start(LogFormat log_format) {
+        format = log_format;
+        if (format == LogFormat::Binario) {
+            logFile.write(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC));
+        }
+        running.store(true, memory_order_release);
+        writer = thread(&AsyncLogger::writerLoop, this);
+    }
+
+    // Descarta todos los mensajes desde ahora, sin iniciar el hilo escritor; lo usa el benchmark para
+    // medir el buffer sin el costo del registro. Debe llamarse antes de crear los hilos de trabajo
+    void disable() {
+        enabled = false;
+    }
+
+    // Detiene el hilo escritor después de vaciar todos los mensajes pendientes
+    void stop() {
+        running.store(false, memory_order_release);
+        if (writer.joinable()) {
+            writer.join();
+        }
+    }
+
+    // Reserva `count` secuencias contiguas para eventos que se registrarán más tarde con logEvent.
+    // Toda secuencia reservada debe registrarse, porque el escritor no avanza hasta recibirla
+    uint64_t reserve(size_t count = 1) {
+        if (!enabled) {
+            return 0;
+        }
+        return next_sequence.fetch_add(count, memory_order_relaxed);
+    }
+
+    // Encola un mensaje sin tomar candados; solo espera si el anillo del hilo está lleno
+    void log(string_view message) {
+        if (!enabled) {
+            return;
+        }
+        size_t chunks = max<size_t>(1, (message.size() + RECORD_TEXT_SIZE - 1) / RECORD_TEXT_SIZE);
+        uint64_t sequence = next_sequence.fetch_add(chunks, memory_order_relaxed);  // Secuencias contiguas para los fragmentos
+        for (size_t i = 0; i < chunks; ++i) {
+            pushText(sequence + i, message.substr(min(message.size(), i * RECORD_TEXT_SIZE), RECORD_TEXT_SIZE));
+        }
+    }
+
+    // Encola un evento con una secuencia reservada con reserve()
+    void logEvent(uint64_t sequence, EventType type, int actor, int64_t item = -1, int depth = -1) {
+        if (!enabled) {
+            return;
+        }
+        Record record;
+        record.sequence = sequence;
+        record.event = EventRecord{elapsedNanoseconds(), item, actor, depth, type};
+        record.length = 0;
+        push(record);
+    }
+
+    // Encola un evento en el orden actual
+    void logEvent(EventType type, int actor, int64_t item = -1, int depth = -1) {
+        logEvent(reserve(), type, actor, item, depth);
+    }
+};
+
+inline AsyncLogger logger;  // Registro global usado por todos los hilos
+
+// Función para imprimir y escribir en archivo (a través del registro asíncrono)
+inline void printMessage(string_view message) {
+    logger.log(message);
+}
+
+// Semáforo contador que además se puede cerrar y cuyas esperas se cancelan con std::stop_token.
+// Tomar o devolver un permiso sin esperar solo usa un contador atómico; el mutex y la variable de
+// condición intervienen únicamente cuando algún hilo tiene que dormir. Sin permisos, el hilo gira,
+// cede o duerme según su WaitStrategy.
+class ClosableSemaphore {
+private:
+    atomic<ptrdiff_t> count;      // Permisos disponibles
+    atomic<int> waiters{0};       // Hilos que esperan (o están por esperar) un permiso
+    atomic<bool> closed{false};   // Indica que no se agregarán más permisos
+    WaitStrategy strategy;        // Cómo esperar cuando no hay permisos
+    AdaptiveSpin spin;            // Vueltas de giro antes de dormir (estrategia adaptativa)
+    mutex wait_mutex;             // Protege la espera en `available`
+    condition_variable_any available;  // Avisa que hay permisos, que se cerró o que se pidió detener
+
+    // Fase de giro de la estrategia adaptativa; retorna true si consiguió un permiso
+    bool spinAdaptive() {
+        int limit = spin.current();
+        for (int i = 0; i < limit; ++i) {
+            cpuRelax();
+            if (count.load(memory_order_relaxed) > 0 && tryAcquire()) {
+                spin.succeeded(limit);
+                return true;
+            }
+        }
+        spin.failed(limit);
+        return false;
+    }
+
+    // Intenta tomar un permiso; retorna true si ya no hay que esperar (lo tomó o el semáforo está
+    // cerrado). Al ver el cierre reintenta, porque los permisos devueltos justo antes de cerrar
+    // pueden haber llegado después del primer intento
+    bool tryAcquireOrClosed(bool& acquired) {
+        acquired = tryAcquire();
+        if (!acquired && closed.load()) {
+            acquired = tryAcquire();
+            return true;
+        }
+        return acquired;
+    }
+
+public:
+    explicit ClosableSemaphore(ptrdiff_t initial, WaitStrategy strategy = WAIT_STRATEGY)
+        : count(initial), strategy(strategy) {}
+
+    // Toma un permiso si hay alguno disponible, sin esperar
+    bool tryAcquire() {
+        ptrdiff_t current = count.load();
+        while (current > 0) {
+            if (count.compare_exchange_weak(current, current - 1)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Toma de una vez hasta `n` permisos de los disponibles, sin esperar; retorna cuántos tomó
+    size_t tryAcquireUpTo(size_t n) {
+        ptrdiff_t current = count.load();
+        while (current > 0 && n > 0) {
+            ptrdiff_t taken = min(current, static_cast<ptrdiff_t>(n));
+            if (count.compare_exchange_weak(current, current - taken)) {
+                return taken;
+            }
+        }
+        return 0;
+    }
+
+    // Espera un permiso hasta el plazo. Retorna false si vence el plazo, si se pidió detener o si
+    // el semáforo está cerrado y ya no quedan permisos
+    bool acquireUntil(chrono::steady_clock::time_point deadline, stop_token stop = {}) {
+        if (tryAcquire()) {
+            return true;
+        }
+        bool acquired = false;
+        if (strategy == WaitStrategy::Giro || strategy == WaitStrategy::Ceder) {
+            // Sin dormir nunca: reintentar hasta tomar el permiso o hasta que ya no tenga sentido esperar
+            retryUntil([&] {
+                return tryAcquireOrClosed(acquired) || stop.stop_requested();
+            }, deadline, strategy);
+            return acquired;
+        }
+        WaitMeter meter;  // Giro y Ceder ya se miden dentro de retryUntil
+        meter.start();
+        if (strategy == WaitStrategy::Adaptativa && spinAdaptive()) {
+            return true;
+        }
+        auto ready = [&] {
+            return tryAcquireOrClosed(acquired);
+        };
+        waiters.fetch_add(1);  // Visible para release() antes de revisar el contador bajo el mutex
+        {
+            unique_lock<mutex> lock(wait_mutex);
+            if (deadline == NO_DEADLINE) {
+                available.wait(lock, stop, ready);
+            } else {
+                available.wait_until(lock, stop, deadline, ready);
+            }
+        }
+        waiters.fetch_sub(1);
+        if (!acquired && deadline != NO_DEADLINE && chrono::steady_clock::now() >= deadline) {
+            meter.timeout();
+        }
+        return acquired;
+    }
+
+    // Espera un permiso sin plazo (ver acquireUntil)
+    bool acquire(stop_token stop = {}) {
+        return acquireUntil(NO_DEADLINE, stop);
+    }
+
+    // Devuelve permisos y despierta a los hilos que esperan
+    void release(ptrdiff_t n = 1) {
+        count.fetch_add(n);
+        if (waiters.load() > 0) {
+            lock_guard<mutex> lock(wait_mutex);
+            if (n == 1) {
+                available.notify_one();
+            } else {
+                available.notify_all();
+            }
+        }
+    }
+
+    // Cierra el semáforo: los permisos restantes se pueden tomar, después las esperas fallan
+    void close() {
+        closed.store(true);
+        lock_guard<mutex> lock(wait_mutex);
+        available.notify_all();
+    }
+};
+
+// Histograma de latencias con buckets log-lineales (al estilo HDR): los valores menores que
+// 2^SUB_BUCKET_BITS se guardan exactos y los demás con un error relativo menor a 1/2^SUB_BUCKET_BITS.
+// Registrar un valor es un cálculo de índice y un incremento, sin memoria dinámica.
+class LatencyHistogram {
+private:
+    static constexpr int SUB_BUCKET_BITS = 5;  // 32 sub-buckets por potencia de dos (error < 3.2%)
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS = (65 - SUB_BUCKET_BITS) * SUB_BUCKETS;  // Cubre todo uint64_t
+
+    array<uint64_t, BUCKETS> counts{};  // Cantidad de valores por bucket
+    uint64_t total = 0;                  // Cantidad de valores registrados
+    uint64_t maximum = 0;                // Mayor valor registrado
+
+    // Bucket de un valor: los SUB_BUCKET_BITS + 1 bits más significativos lo identifican
+    static size_t indexOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return value;
+        }
+        int msb = 63 - countl_zero(value);
+        int shift = msb - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    // Mayor valor que cae en el bucket
+    static uint64_t highestValueAt(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+        uint64_t lowest = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lowest + ((uint64_t(1) << shift) - 1);
+    }
+
+public:
+    // Registra un valor
+    void record(uint64_t value) {
+        ++counts[indexOf(value)];
+        ++total;
+        maximum = max(maximum, value);
+    }
+
+    // Suma los valores de otro histograma
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        maximum = max(maximum, other.maximum);
+    }
+
+    // Valor bajo el cual está el `percent` por ciento de los registros
+    uint64_t percentile(double percent) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t target = max<uint64_t>(1, static_cast<uint64_t>(percent / 100.0 * total + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= target) {
+                return min(highestValueAt(i), maximum);
+            }
+        }
+        return maximum;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t maxValue() const { return maximum; }
+};
+
+// Ítem guardado en el buffer junto con el instante en que se insertó
+template <typename T>
+struct Slot {
+    T item;                // Ítem producido
+    uint64_t enqueued_ns;  // Marca de tiempo de la inserción (elapsedNanoseconds)
+
+    // Construye el ítem en el lugar a partir de `args`
+    template <typename... Args>
+    explicit Slot(uint64_t enqueued_ns, Args&&... args) : item(forward<Args>(args)...), enqueued_ns(enqueued_ns) {}
+};
+
+// Identificador con el que un ítem aparece en el log: el propio valor para tipos enteros, el campo
+// `id` si el tipo lo tiene y -1 en cualquier otro caso
+template <typename T>
+int64_t eventItemId(const T& item) {
+    if constexpr (integral<T>) {
+        return item;
+    } else if constexpr (requires { { item.id } -> convertible_to<int64_t>; }) {
+        return item.id;
+    } else {
+        return -1;
+    }
+}
+
+// Elige la implementación concreta del buffer cuando se pidió el modo automático (el anillo SPSC
+// no sirve para descartar el ítem más antiguo, porque el productor no puede extraer ítems)
+inline BufferMode resolveBufferMode(BufferMode requested, int producers, int consumers, OverflowPolicy overflow = OVERFLOW_POLICY) {
+    if (requested != BufferMode::Automatico) {
+        return requested;
+    }
+    bool spsc = producers == 1 && consumers == 1 && overflow != OverflowPolicy::DescartarAntiguo;
+    return spsc ? BufferMode::SPSC : BufferMode::Semaforo;
+}
+
+// Resultado de ofrecer un ítem al buffer según la política de desborde
+enum class OfferResult {
+    Insertado,   // El ítem quedó en el buffer
+    Descartado,  // La política descartó o rechazó el ítem
+    Lleno        // La política pide esperar espacio para este ítem
+};
+
+// Cantidad de veces que se dio cada resultado con el buffer lleno
+struct OverflowStats {
+    uint64_t waits;           // Esperas de productores hasta que hubo espacio
+    uint64_t rejected;        // Ítems rechazados (Fallar)
+    uint64_t dropped_newest;  // Ítems nuevos descartados (DescartarNuevo)
+    uint64_t dropped_oldest;  // Ítems antiguos descartados para insertar uno nuevo (DescartarAntiguo)
+    uint64_t shed;            // Ítems descartados por el muestreo (Muestreo)
+
+    OverflowStats& operator+=(const OverflowStats& other) {
+        waits += other.waits;
+        rejected += other.rejected;
+        dropped_newest += other.dropped_newest;
+        dropped_oldest += other.dropped_oldest;
+        shed += other.shed;
+        return *this;
+    }
+};
+
+// Buffer acotado compartido entre productores y consumidores, genérico en el tipo de ítem.
+// Acepta tipos que solo se pueden mover (por ejemplo std::unique_ptr) y construye los ítems
+// directamente en su posición del buffer con emplace, sin copias intermedias.
+template <typename T>
+class Buffer {
+private:
+    // Cada grupo de estado empieza en su propia línea de caché. Los dos lados escriben los dos
+    // semáforos (un productor toma `spaces` y libera `items`, un consumidor al revés), así que esas
+    // líneas igual pasan de un núcleo a otro; separarlas hace que cada operación compita solo con
+    // las que usan el mismo semáforo, y que ninguna invalide la línea del candado de la cola
+    // (ver falso_compartir.cpp)
+    BufferMode mode;    // Implementación usada para almacenar los ítems (solo lectura)
+    WaitStrategy wait;  // Estrategia de espera con el buffer lleno o vacío (solo lectura)
+    OverflowPolicy overflow;  // Qué hace produce() con el buffer lleno (solo lectura)
+
+    // Cola y candado del modo Semaforo, que ambos lados modifican bajo el candado
+    alignas(CACHE_LINE_SIZE) TimedLock buffer_mutex;   // Semáforo para sincronizar el acceso al buffer (modo Semaforo)
+    deque<Slot<T>> buffer; // Cola que representa el buffer compartido (modo Semaforo)
+
+    // Anillos de los modos sin candado (separan internamente sus índices de productores y consumidores)
+    MPMCRing<Slot<T>> ring; // Anillo sin bloqueo (modo MPMC)
+    SPSCRing<Slot<T>> spsc; // Anillo de un productor y un consumidor (modo SPSC)
+    vector<unique_ptr<MPMCRing<Slot<T>>>> lanes; // Un anillo por grupo de productores (modo Carriles)
+
+    // Espacios que los productores toman antes de insertar (y los consumidores devuelven), junto
+    // con los contadores de desborde, que solo escriben los productores
+    alignas(CACHE_LINE_SIZE) ClosableSemaphore spaces; // Semáforo que indica los espacios disponibles en el buffer
+    atomic<uint64_t> producer_waits{0}; // Veces que un productor encontró el buffer lleno
+    atomic<uint64_t> rejected{0};       // Ítems rechazados con la política Fallar
+    atomic<uint64_t> dropped_newest{0}; // Ítems nuevos descartados con la política DescartarNuevo
+    atomic<uint64_t> dropped_oldest{0}; // Ítems antiguos descartados con la política DescartarAntiguo
+    atomic<uint64_t> shed{0};           // Ítems descartados por el muestreo
+    atomic<uint64_t> sampled{0};        // Ítems que encontraron el buffer lleno con la política Muestreo
+    AdaptiveSpin producer_spin;         // Giro de los productores que esperan espacio en un anillo (modos SPSC y Carriles)
+
+    // Ítems que los consumidores toman antes de consumir (y los productores devuelven)
+    alignas(CACHE_LINE_SIZE) ClosableSemaphore items; // Semáforo que indica cuántos ítems hay en el buffer para consumir
+    atomic<bool> closed{false};        // Indica que los productores terminaron (usado por los modos SPSC y Carriles)
+    AdaptiveSpin consumer_spin;        // Giro de los consumidores que esperan ítems en un anillo (modos SPSC y Carriles)
+
+public:
+    // Constructor que inicializa el semáforo `spaces` con la capacidad del buffer. En el modo Carriles
+    // la capacidad se reparte exactamente entre `lane_count` anillos (a lo sumo uno por espacio, para
+    // que ninguno quede sin capacidad); `wait` decide cómo esperan productores y consumidores y
+    // `overflow` qué hace produce() con el buffer lleno
+    Buffer(int capacity, BufferMode mode = BUFFER_MODE, int lane_count = 1, WaitStrategy wait = WAIT_STRATEGY,
+           OverflowPolicy overflow = OVERFLOW_POLICY)
+        : mode(mode), wait(wait), overflow(overflow), ring(mode == BufferMode::MPMC ? capacity : 1),
+          spsc(mode == BufferMode::SPSC ? capacity : 1), spaces(capacity, wait), items(0, wait) {
+        if (mode == BufferMode::Carriles) {
+            int count = max(1, min(lane_count, capacity));
+            for (int i = 0; i < count; ++i) {
+                lanes.push_back(make_unique<MPMCRing<Slot<T>>>(capacity / count + (i < capacity % count ? 1 : 0)));
+            }
+        }
+    }
+
+    // Indica que no se producirán más ítems: los consumidores vacían lo que queda y luego terminan
+    void close() {
+        closed.store(true, memory_order_release);
+        items.close();
+    }
+
+    // Método para que un productor añada un ítem al buffer aplicando la política de desborde;
+    // espera sin plazo solo si la política lo pide. Retorna false si el ítem no quedó en el buffer
+    bool produce(int id, T item) {
+        OfferResult result = overflow == OverflowPolicy::Bloquear ? OfferResult::Lleno : tryOffer(id, item);
+        if (result == OfferResult::Lleno) {
+            emplaceUntil(id, NO_DEADLINE, std::move(item));
+            return true;
+        }
+        return result == OfferResult::Insertado;
+    }
+
+    // Ofrece un ítem sin esperar y, si el buffer está lleno, aplica la política de desborde.
+    // El ítem solo se mueve si queda insertado: con Lleno sigue disponible para esperar espacio
+    OfferResult tryOffer(int id, T& item) {
+        while (!tryProduce(id, std::move(item))) {
+            switch (overflow) {
+            case OverflowPolicy::Bloquear:
+                return OfferResult::Lleno;
+            case OverflowPolicy::Fallar:
+                return discard(id, item, rejected);
+            case OverflowPolicy::DescartarNuevo:
+                return discard(id, item, dropped_newest);
+            case OverflowPolicy::Muestreo:
+                if (sampled.fetch_add(1, memory_order_relaxed) % static_cast<uint64_t>(SAMPLE_RATE) == 0) {
+                    return OfferResult::Lleno;  // Ítem elegido por el muestreo: espera espacio
+                }
+                return discard(id, item, shed);
+            case OverflowPolicy::DescartarAntiguo:
+                if (!evictOldest(id)) {
+                    return OfferResult::Lleno;  // Los ítems del buffer ya tienen consumidor: pronto habrá espacio
+                }
+                break;  // Reintentar con el espacio liberado (otro productor puede ganarlo antes)
+            }
+        }
+        return OfferResult::Insertado;
+    }
+
+    // Construye un ítem directamente en el buffer a partir de `args`; espera sin plazo hasta que haya espacio
+    template <typename... Args>
+    void emplace(int id, Args&&... args) {
+        emplaceUntil(id, NO_DEADLINE, forward<Args>(args)...);
+    }
+
+    // Intenta añadir un ítem sin esperar; retorna false si el buffer está lleno (el ítem no se mueve)
+    template <typename U>
+    bool tryProduce(int id, U&& item) {
+        return emplaceUntil(id, chrono::steady_clock::time_point::min(), forward<U>(item));
+    }
+
+    // Cantidad de veces que un productor encontró el buffer lleno y tuvo que esperar
+    uint64_t producerWaits() const {
+        return producer_waits.load(memory_order_relaxed);
+    }
+
+    // Resultados de las inserciones que encontraron el buffer lleno
+    OverflowStats overflowStats() const {
+        return {producer_waits.load(memory_order_relaxed), rejected.load(memory_order_relaxed),
+                dropped_newest.load(memory_order_relaxed), dropped_oldest.load(memory_order_relaxed),
+                shed.load(memory_order_relaxed)};
+    }
+
+    // Cuenta una espera de un productor que reintenta por su cuenta con tryProduce (tareas del ejecutor)
+    void countProducerWait() {
+        producer_waits.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Construye un ítem en el buffer esperando espacio hasta el plazo; retorna false si el plazo
+    // vence (en ese caso `args` no se usan).
+    // Solo la modificación de la cola ocurre dentro de la sección crítica; allí se reserva la
+    // secuencia del evento y el mensaje se construye y se registra después de liberarla.
+    template <typename... Args>
+    bool emplaceUntil(int id, chrono::steady_clock::time_point deadline, Args&&... args) {
+        uint64_t sequence;
+        int64_t item_id = -1;  // Identificador del ítem para el log, leído antes de publicarlo
+        int depth;        // Ítems en el buffer después de la inserción
+        auto inspect = [&](const Slot<T>& slot) { item_id = eventItemId(slot.item); };
+        if (mode == BufferMode::SPSC) {
+            // Sin semáforos: el anillo indica directamente si hay espacio. Con un solo productor el
+            // espacio observado no puede desaparecer, así que la secuencia se reserva antes de
+            // publicar y el consumo de este ítem siempre queda registrado después
+            if (spsc.full()) {
+                if (chrono::steady_clock::now() >= deadline) {
+                    return false;
+                }
+                producer_waits.fetch_add(1, memory_order_relaxed);  // Se cuenta la espera en lugar de registrarla
+                if (!retryUntil([&] { return !spsc.full(); }, deadline, wait, &producer_spin)) {
+                    return false;
+                }
+            }
+            sequence = logger.reserve();
+            spsc.tryEmplaceInspect(inspect, elapsedNanoseconds(), forward<Args>(args)...);
+            logger.logEvent(sequence, EventType::Insercion, id, item_id, static_cast<int>(spsc.size()));
+            return true;
+        }
+        if (mode == BufferMode::Carriles) {
+            // Sin semáforos: el productor solo compite con los que comparten su carril. La celda se
+            // reserva antes que la secuencia, para que ninguna secuencia reservada quede sin registrar
+            MPMCRing<Slot<T>>& lane = laneOf(id);
+            optional<size_t> pos = lane.tryClaim();
+            if (!pos) {
+                if (chrono::steady_clock::now() >= deadline) {
+                    return false;
+                }
+                producer_waits.fetch_add(1, memory_order_relaxed);  // Se cuenta la espera en lugar de registrarla
+                if (!retryUntil([&] { return (pos = lane.tryClaim()).has_value(); }, deadline, wait, &producer_spin)) {
+                    return false;
+                }
+            }
+            sequence = logger.reserve();
+            inspect(*new (lane.storage(*pos).bytes) Slot<T>(elapsedNanoseconds(), forward<Args>(args)...));
+            lane.publish(*pos);
+            logger.logEvent(sequence, EventType::Insercion, id, item_id, static_cast<int>(lane.size()));
+            return true;
+        }
+
+        // Toma un espacio; si no hay, duerme hasta que un consumidor libere uno o venza el plazo
+        if (!spaces.tryAcquire()) {
+            if (chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            producer_waits.fetch_add(1, memory_order_relaxed);  // Se cuenta la espera en lugar de registrarla
+            if (!spaces.acquireUntil(deadline)) {
+                return false;
+            }
+        }
+        uint64_t enqueued_ns = elapsedNanoseconds(); // Marca de tiempo tomada fuera de la sección crítica
+        if (mode == BufferMode::MPMC) {
+            // El semáforo `spaces` garantiza una celda libre; solo se reintenta mientras un consumidor
+            // termina de liberar la celda que le corresponde. La secuencia se reserva antes de publicar
+            // para que ningún consumo del ítem quede registrado antes que su inserción
+            sequence = logger.reserve();
+            while (!ring.tryEmplaceInspect(inspect, enqueued_ns, forward<Args>(args)...)) {
+                this_thread::yield();
+            }
+            depth = static_cast<int>(ring.size());
+        } else {
+            buffer_mutex.acquire(); // Adquiere el semáforo para acceder al buffer
+            inspect(buffer.emplace_back(enqueued_ns, forward<Args>(args)...)); // Inserta el ítem en el buffer
+            sequence = logger.reserve(); // Ordena el evento respecto de los demás accesos al buffer
+            depth = static_cast<int>(buffer.size());
+            buffer_mutex.release(); // Libera el semáforo después de modificar el buffer
+        }
+        items.release(); // Indica que hay un nuevo ítem disponible
+        logger.logEvent(sequence, EventType::Insercion, id, item_id, depth); // Registra el evento fuera de la sección crítica
+        return true;
+    }
+
+    // Método para que un consumidor tome (moviendo) un ítem del buffer.
+    // Espera sin plazo; retorna un valor vacío cuando el buffer está cerrado y vacío o cuando se pidió
+    // detener. Si se entrega `latency`, registra allí el tiempo que el ítem pasó en el buffer
+    optional<T> consume(int id, stop_token stop = {}, LatencyHistogram* latency = nullptr) {
+        optional<Slot<T>> slot;
+        uint64_t sequence;
+        int depth;  // Ítems en el buffer después del consumo
+        if (mode == BufferMode::SPSC || mode == BufferMode::Carriles) {
+            // Sin semáforos: los anillos indican directamente si hay ítems
+            retryUntil([&] {
+                slot = tryPopDirect(depth);
+                return slot.has_value() || closed.load(memory_order_acquire) || stop.stop_requested();
+            }, NO_DEADLINE, wait, &consumer_spin);
+            if (!slot && !stop.stop_requested()) {
+                slot = tryPopDirect(depth);  // Últimos ítems publicados justo antes del cierre
+            }
+            if (!slot) {
+                return nullopt; // No hay más ítems que consumir
+            }
+            recordLatency(*slot, latency);
+            logger.logEvent(EventType::Consumo, id, eventItemId(slot->item), depth);
+            return std::move(slot->item); // Retorna el ítem consumido
+        }
+
+        // Espera un ítem; tras el cierre solo quedan los permisos de los ítems pendientes
+        if (!items.acquire(stop)) {
+            return nullopt; // No hay más ítems que consumir
+        }
+
+        if (mode == BufferMode::MPMC) {
+            // El semáforo `items` garantiza un ítem; solo se reintenta mientras su productor termina de publicarlo
+            while (!(slot = ring.tryPop())) {
+                this_thread::yield();
+            }
+            sequence = logger.reserve();
+            depth = static_cast<int>(ring.size());
+        } else {
+            buffer_mutex.acquire(); // Adquiere el semáforo para acceder al buffer
+            slot.emplace(std::move(buffer.front())); // Obtiene el ítem en la parte frontal del buffer
+            buffer.pop_front(); // Elimina el ítem del buffer
+            sequence = logger.reserve(); // Ordena el evento respecto de los demás accesos al buffer
+            depth = static_cast<int>(buffer.size());
+            buffer_mutex.release(); // Libera el semáforo después de modificar el buffer
+        }
+        spaces.release(); // Indica que hay un espacio disponible en el buffer
+        recordLatency(*slot, latency);
+        logger.logEvent(sequence, EventType::Consumo, id, eventItemId(slot->item), depth); // Registra el evento fuera de la sección crítica
+        return std::move(slot->item); // Retorna el ítem consumido
+    }
+
+    // Ítem que un productor escribe directamente en la memoria del buffer (ver claim()). Los
+    // consumidores no lo ven hasta publish(), que se llama también al destruir el objeto
+    class WriteSlot {
+    public:
+        WriteSlot(WriteSlot&& other)
+            : owner(exchange(other.owner, nullptr)), id(other.id), pos(other.pos), lane(other.lane),
+              local(std::move(other.local)), stored(other.stored) {}
+        WriteSlot& operator=(WriteSlot&&) = delete;
+
+        ~WriteSlot() {
+            publish();
+        }
+
+        T& operator*() { return slot().item; }
+        T* operator->() { return &slot().item; }
+
+        // Publica el ítem para los consumidores; después ya no se puede modificar
+        void publish() {
+            if (owner != nullptr) {
+                exchange(owner, nullptr)->publishClaimed(id, pos, lane, slot(), local);
+            }
+        }
+
+    private:
+        friend class Buffer;
+
+        WriteSlot(Buffer& owner, int id, size_t pos, MPMCRing<Slot<T>>* lane)
+            : owner(&owner), id(id), pos(pos), lane(lane) {}
+
+        Slot<T>& slot() { return local ? *local : *stored; }
+
+        Buffer* owner;           // Buffer donde se publicará el ítem (nulo una vez publicado)
+        int id;                  // Productor que reservó el espacio
+        size_t pos;              // Posición reservada en el anillo (modos MPMC, SPSC y Carriles)
+        MPMCRing<Slot<T>>* lane; // Anillo MPMC de la posición (modos MPMC y Carriles)
+        optional<Slot<T>> local; // Ítem mientras se escribe (modo Semaforo)
+        Slot<T>* stored = nullptr; // Ítem construido en el anillo (modos MPMC, SPSC y Carriles)
+    };
+
+    // Ítem que un consumidor usa directamente en la memoria del buffer (ver peek()). Su espacio
+    // no se reutiliza hasta release(), que se llama también al destruir el objeto
+    class ReadSlot {
+    public:
+        ReadSlot(ReadSlot&& other)
+            : owner(exchange(other.owner, nullptr)), pos(other.pos), lane(other.lane),
+              local(std::move(other.local)), stored(exchange(other.stored, nullptr)) {}
+        ReadSlot& operator=(ReadSlot&&) = delete;
+
+        ~ReadSlot() {
+            release();
+        }
+
+        // Indica si se obtuvo un ítem (falso cuando el buffer está cerrado y vacío o se pidió detener)
+        explicit operator bool() const { return local.has_value() || stored != nullptr; }
+
+        T& operator*() { return slot().item; }
+        T* operator->() { return &slot().item; }
+
+        // Destruye el ítem y devuelve su espacio a los productores
+        void release() {
+            if (owner != nullptr) {
+                exchange(owner, nullptr)->releasePeeked(pos, lane);
+            }
+            local.reset();
+            stored = nullptr;
+        }
+
+    private:
+        friend class Buffer;
+
+        ReadSlot() = default;
+
+        Slot<T>& slot() { return local ? *local : *stored; }
+
+        Buffer* owner = nullptr;   // Buffer al que se devuelve el espacio (nulo si no hay que devolverlo)
+        size_t pos = 0;            // Posición reservada en el anillo (modos MPMC, SPSC y Carriles)
+        MPMCRing<Slot<T>>* lane = nullptr; // Anillo MPMC de la posición (modos MPMC y Carriles)
+        optional<Slot<T>> local;   // Ítem ya retirado de la cola (modo Semaforo)
+        Slot<T>* stored = nullptr; // Ítem dentro del anillo (modos MPMC, SPSC y Carriles)
+    };
+
+    // Reserva un espacio (esperando sin plazo) y construye allí el ítem a partir de `args`, para que
+    // el productor lo termine de escribir en el lugar y luego lo publique.
+    // En los modos con anillos el ítem vive en el anillo desde el principio y no se copia ni se mueve;
+    // en el modo Semaforo la cola no tiene posiciones fijas y el ítem se mueve una vez al publicarlo
+    template <typename... Args>
+    WriteSlot claim(int id, Args&&... args) {
+        size_t pos = 0;
+        MPMCRing<Slot<T>>* lane = nullptr;
+        if (mode == BufferMode::SPSC) {
+            if (spsc.full()) {
+                producer_waits.fetch_add(1, memory_order_relaxed);  // Se cuenta la espera en lugar de registrarla
+                retryUntil([&] { return !spsc.full(); }, NO_DEADLINE, wait, &producer_spin);
+            }
+            pos = *spsc.tryClaim();  // Con un solo productor el espacio observado no puede desaparecer
+        } else if (mode == BufferMode::Carriles) {
+            lane = &laneOf(id);
+            optional<size_t> claimed = lane->tryClaim();
+            if (!claimed) {
+                producer_waits.fetch_add(1, memory_order_relaxed);  // Se cuenta la espera en lugar de registrarla
+                retryUntil([&] { return (claimed = lane->tryClaim()).has_value(); }, NO_DEADLINE, wait, &producer_spin);
+            }
+            pos = *claimed;
+        } else {
+            if (!spaces.tryAcquire()) {
+                producer_waits.fetch_add(1, memory_order_relaxed);  // Se cuenta la espera en lugar de registrarla
+                spaces.acquire();
+            }
+            if (mode == BufferMode::MPMC) {
+                optional<size_t> claimed;
+                while (!(claimed = ring.tryClaim())) {
+                    this_thread::yield();  // Un consumidor aún está liberando la celda
+                }
+                pos = *claimed;
+                lane = &ring;
+            }
+        }
+        WriteSlot slot(*this, id, pos, lane);
+        if (mode == BufferMode::Semaforo) {
+            slot.local.emplace(0, forward<Args>(args)...);
+        } else {
+            ItemStorage<Slot<T>>& storage = lane != nullptr ? lane->storage(pos) : spsc.storage(pos);
+            slot.stored = new (storage.bytes) Slot<T>(0, forward<Args>(args)...);
+        }
+        return slot;
+    }
+
+    // Toma el próximo ítem (esperando sin plazo) para que el consumidor lo use en el lugar y luego lo
+    // libere. Retorna un objeto vacío cuando el buffer está cerrado y vacío o cuando se pidió detener.
+    // El consumo se registra (y la latencia se mide) al tomar el ítem. En el modo MPMC mantener el
+    // ítem retrasa al productor que reutiliza esa celda; en el modo Semaforo el ítem se mueve fuera
+    // de la cola y su espacio se libera de inmediato
+    ReadSlot peek(int id, stop_token stop = {}, LatencyHistogram* latency = nullptr) {
+        ReadSlot slot;
+        uint64_t sequence;
+        int depth;  // Ítems en el buffer después del consumo
+        if (mode == BufferMode::SPSC || mode == BufferMode::Carriles) {
+            optional<size_t> pos;
+            auto tryPeek = [&] {
+                if (mode == BufferMode::SPSC) {
+                    pos = spsc.tryPeek();
+                    return pos.has_value();
+                }
+                return scanLanes([&](MPMCRing<Slot<T>>& lane) {
+                    pos = lane.tryPeek();
+                    slot.lane = &lane;
+                    return pos.has_value();
+                });
+            };
+            retryUntil([&] {
+                return tryPeek() || closed.load(memory_order_acquire) || stop.stop_requested();
+            }, NO_DEADLINE, wait, &consumer_spin);
+            if (!pos && !stop.stop_requested()) {
+                tryPeek();  // Últimos ítems publicados justo antes del cierre
+            }
+            if (!pos) {
+                return slot; // No hay más ítems que consumir
+            }
+            slot.owner = this;
+            slot.pos = *pos;
+            if (mode == BufferMode::SPSC) {
+                slot.stored = spsc.storage(*pos).get();
+                depth = static_cast<int>(spsc.size()) - 1;  // El ítem tomado sigue contado hasta release()
+            } else {
+                slot.stored = slot.lane->storage(*pos).get();
+                depth = static_cast<int>(slot.lane->size());
+            }
+            recordLatency(*slot.stored, latency);
+            logger.logEvent(EventType::Consumo, id, eventItemId(slot.stored->item), depth);
+            return slot;
+        }
+
+        if (!items.acquire(stop)) {
+            return slot; // No hay más ítems que consumir
+        }
+        if (mode == BufferMode::MPMC) {
+            optional<size_t> pos;
+            while (!(pos = ring.tryPeek())) {
+                this_thread::yield();  // El productor de ese ítem aún lo está publicando
+            }
+            sequence = logger.reserve();
+            depth = static_cast<int>(ring.size());
+            slot.owner = this;
+            slot.pos = *pos;
+            slot.lane = &ring;
+            slot.stored = ring.storage(*pos).get();
+        } else {
+            buffer_mutex.acquire(); // Adquiere el semáforo para acceder al buffer
+            slot.local.emplace(std::move(buffer.front())); // Retira el ítem de la parte frontal del buffer
+            buffer.pop_front();
+            sequence = logger.reserve(); // Ordena el evento respecto de los demás accesos al buffer
+            depth = static_cast<int>(buffer.size());
+            buffer_mutex.release(); // Libera el semáforo después de modificar el buffer
+            spaces.release(); // El espacio en la cola ya quedó libre
+        }
+        recordLatency(slot.slot(), latency);
+        logger.logEvent(sequence, EventType::Consumo, id, eventItemId(*slot), depth);
+        return slot;
+    }
+
+    // Inserta (moviendo) todos los ítems de `batch`, esperando espacio cuando haga falta.
+    // Cada vuelta toma de una vez todos los espacios libres (hasta MAX_BATCH) y, en el modo Semaforo,
+    // inserta esos ítems con una sola toma del candado. Retorna cuántos ítems quedaron en el buffer
+    // (menos que `batch.size()` si la política de desborde descartó o rechazó alguno)
+    size_t produceN(int id, span<T> batch) {
+        if (mode == BufferMode::Carriles || overflow != OverflowPolicy::Bloquear) {
+            // Sin semáforos ni candado que amortizar, o la política de desborde decide ítem por ítem
+            size_t inserted = 0;
+            for (T& item : batch) {
+                inserted += produce(id, std::move(item));
+            }
+            return inserted;
+        }
+        size_t inserted = batch.size();
+        while (!batch.empty()) {
+            size_t count = acquireSpaces(min(batch.size(), MAX_BATCH));
+            insertBatch(id, batch.first(count));
+            batch = batch.subspan(count);
+        }
+        return inserted;
+    }
+
+    // Toma hasta `out.size()` ítems (al menos uno, esperando sin plazo) y los mueve a `out`.
+    // Retorna cuántos ítems tomó; 0 cuando el buffer está cerrado y vacío o cuando se pidió detener
+    size_t consumeN(int id, span<T> out, stop_token stop = {}, LatencyHistogram* latency = nullptr) {
+        size_t limit = min(out.size(), MAX_BATCH);
+        if (limit == 0) {
+            return 0;
+        }
+        if (mode == BufferMode::SPSC || mode == BufferMode::Carriles) {
+            // El primer ítem se espera como en consume(); los demás solo si ya están publicados
+            optional<T> first = consume(id, stop, latency);
+            if (!first) {
+                return 0;
+            }
+            out[0] = std::move(*first);
+            return 1 + popDirectN(id, out.subspan(1, limit - 1), latency);
+        }
+
+        // Espera el primer ítem y toma de una vez los permisos de los demás que ya estén disponibles
+        if (!items.acquire(stop)) {
+            return 0;
+        }
+        return takePermitted(id, out, 1 + items.tryAcquireUpTo(limit - 1), latency);
+    }
+
+    // Toma sin esperar hasta `out.size()` ítems de los que ya están disponibles y los mueve a `out`.
+    // Retorna cuántos ítems tomó (0 si el buffer estaba vacío)
+    size_t tryConsumeN(int id, span<T> out, LatencyHistogram* latency = nullptr) {
+        size_t limit = min(out.size(), MAX_BATCH);
+        if (mode == BufferMode::SPSC || mode == BufferMode::Carriles) {
+            return popDirectN(id, out.first(limit), latency);
+        }
+        size_t permits = items.tryAcquireUpTo(limit);
+        return permits == 0 ? 0 : takePermitted(id, out, permits, latency);
+    }
+
+    // Indica si ya se llamó a close()
+    bool isClosed() const {
+        return closed.load(memory_order_acquire);
+    }
+
+    // Giro adaptativo de los consumidores que esperan ítems reintentando por su cuenta con
+    // tryConsumeN (consumidores con robo de trabajo)
+    AdaptiveSpin& consumerSpin() {
+        return consumer_spin;
+    }
+
+    // Ítems que hay en el buffer en este momento (aproximado mientras otros hilos lo modifican)
+    size_t depth() {
+        switch (mode) {
+        case BufferMode::MPMC:
+            return ring.size();
+        case BufferMode::SPSC:
+            return spsc.size();
+        case BufferMode::Carriles: {
+            size_t total = 0;
+            for (const auto& lane : lanes) {
+                total += lane->size();
+            }
+            return total;
+        }
+        default: {
+            buffer_mutex.acquire(); // Adquiere el semáforo para leer el tamaño de la cola
+            size_t size = buffer.size();
+            buffer_mutex.release();
+            return size;
+        }
+        }
+    }
+
+private:
+    // Registra el descarte de un ítem que no entró al buffer y lo cuenta en `counter`
+    OfferResult discard(int id, const T& item, atomic<uint64_t>& counter) {
+        counter.fetch_add(1, memory_order_relaxed);
+        logger.logEvent(EventType::Descarte, id, eventItemId(item));
+        return OfferResult::Descartado;
+    }
+
+    // Descarta el ítem más antiguo para dejar un espacio libre (política DescartarAntiguo). En el
+    // modo Carriles solo se descarta del carril del productor, que es donde necesita el espacio.
+    // Retorna false si no hay un ítem que descartar sin esperar (en el modo SPSC nunca lo hay,
+    // porque solo el consumidor puede extraer)
+    bool evictOldest(int id) {
+        optional<Slot<T>> slot;
+        uint64_t sequence;
+        int depth;  // Ítems en el buffer (o en el carril) después del descarte
+        if (mode == BufferMode::SPSC) {
+            return false;
+        }
+        if (mode == BufferMode::Carriles) {
+            MPMCRing<Slot<T>>& lane = laneOf(id);
+            if (!(slot = lane.tryPop())) {
+                return false;
+            }
+            sequence = logger.reserve();
+            depth = static_cast<int>(lane.size());
+        } else {
+            if (!items.tryAcquire()) {
+                return false;
+            }
+            if (mode == BufferMode::MPMC) {
+                while (!(slot = ring.tryPop())) {
+                    this_thread::yield();  // El productor de ese ítem aún lo está publicando
+                }
+                sequence = logger.reserve();
+                depth = static_cast<int>(ring.size());
+            } else {
+                buffer_mutex.acquire(); // Adquiere el semáforo para acceder al buffer
+                slot.emplace(std::move(buffer.front())); // El ítem más antiguo está al frente de la cola
+                buffer.pop_front();
+                sequence = logger.reserve(); // Ordena el evento respecto de los demás accesos al buffer
+                depth = static_cast<int>(buffer.size());
+                buffer_mutex.release(); // Libera el semáforo después de modificar el buffer
+            }
+            spaces.release(); // El espacio queda libre para la inserción que sigue
+        }
+        dropped_oldest.fetch_add(1, memory_order_relaxed);
+        logger.logEvent(sequence, EventType::Descarte, id, eventItemId(slot->item), depth);
+        return true;
+    }
+
+    // Extrae sin esperar hasta `out.size()` ítems en los modos sin semáforos (SPSC y Carriles)
+    size_t popDirectN(int id, span<T> out, LatencyHistogram* latency) {
+        size_t count = 0;
+        int depth;  // Ítems que quedan en el anillo del que salió el ítem
+        while (count < out.size()) {
+            optional<Slot<T>> slot = tryPopDirect(depth);
+            if (!slot) {
+                break;
+            }
+            recordLatency(*slot, latency);
+            logger.logEvent(EventType::Consumo, id, eventItemId(slot->item), depth);
+            out[count++] = std::move(slot->item);
+        }
+        return count;
+    }
+
+    // Toma `permits` ítems cuyos permisos de `items` ya se adquirieron (modos Semaforo y MPMC).
+    // En el modo Semaforo el lote entero se toma con una sola toma del candado
+    size_t takePermitted(int id, span<T> out, size_t permits, LatencyHistogram* latency) {
+        array<int64_t, MAX_BATCH> ids;  // Identificadores para el log, registrados fuera de la sección crítica
+        size_t count = 0;
+        uint64_t sequence;
+        int depth;  // Ítems en el buffer después de la vuelta
+        auto take = [&](Slot<T>&& slot) {
+            recordLatency(slot, latency);
+            ids[count] = eventItemId(slot.item);
+            out[count++] = std::move(slot.item);
+        };
+        if (mode == BufferMode::MPMC) {
+            while (count < permits) {
+                optional<Slot<T>> slot = ring.tryPop();
+                if (!slot) {
+                    this_thread::yield();  // El productor de ese ítem aún lo está publicando
+                    continue;
+                }
+                take(std::move(*slot));
+            }
+            sequence = logger.reserve(count);
+            depth = static_cast<int>(ring.size());
+        } else {
+            buffer_mutex.acquire(); // Una sola toma del candado para todo el lote
+            while (count < permits) {
+                take(std::move(buffer.front()));
+                buffer.pop_front();
+            }
+            sequence = logger.reserve(count); // Secuencias contiguas para los eventos del lote
+            depth = static_cast<int>(buffer.size());
+            buffer_mutex.release();
+        }
+        spaces.release(count); // Indica que hay `count` espacios disponibles
+        for (size_t j = 0; j < count; ++j) {
+            logger.logEvent(sequence + j, EventType::Consumo, id, ids[j], depth + static_cast<int>(count - j - 1));
+        }
+        return count;
+    }
+
+    // Carril en el que escribe un productor (modo Carriles)
+    MPMCRing<Slot<T>>& laneOf(int id) {
+        return *lanes[static_cast<size_t>(id) % lanes.size()];
+    }
+
+    // Recorre los carriles por turnos, empezando después del último carril que atendió este hilo
+    // (el primer carril de cada hilo es aleatorio, salvo en la simulación, que debe ser reproducible),
+    // hasta que `take` logre tomar algo de uno
+    template <typename Take>
+    bool scanLanes(Take take) {
+        thread_local size_t cursor = VIRTUAL_TIME ? 0 : hash<thread::id>{}(this_thread::get_id());
+        for (size_t k = 0; k < lanes.size(); ++k) {
+            size_t index = (cursor + k) % lanes.size();
+            if (take(*lanes[index])) {
+                cursor = index + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Extrae un ítem en los modos sin semáforos (SPSC y Carriles); `depth` recibe los ítems que
+    // quedan en el anillo del que salió
+    optional<Slot<T>> tryPopDirect(int& depth) {
+        optional<Slot<T>> slot;
+        if (mode == BufferMode::SPSC) {
+            slot = spsc.tryPop();
+            depth = static_cast<int>(spsc.size());
+        } else {
+            scanLanes([&](MPMCRing<Slot<T>>& lane) {
+                slot = lane.tryPop();
+                depth = static_cast<int>(lane.size());
+                return slot.has_value();
+            });
+        }
+        return slot;
+    }
+
+    // Publica un ítem escrito con claim(); la latencia se mide desde la publicación
+    void publishClaimed(int id, size_t pos, MPMCRing<Slot<T>>* lane, Slot<T>& slot, optional<Slot<T>>& local) {
+        slot.enqueued_ns = elapsedNanoseconds();
+        int64_t item_id = eventItemId(slot.item);  // Leído antes de que un consumidor pueda tomar el ítem
+        uint64_t sequence = 0;
+        int depth;  // Ítems en el buffer (o en el carril) después de la inserción
+        if (mode != BufferMode::Semaforo) {
+            sequence = logger.reserve();  // Antes de publicar, como en emplaceUntil()
+            if (mode == BufferMode::SPSC) {
+                spsc.publish(pos);
+                depth = static_cast<int>(spsc.size());
+            } else {
+                lane->publish(pos);
+                depth = static_cast<int>(lane->size());
+            }
+        } else {
+            buffer_mutex.acquire(); // Adquiere el semáforo para acceder al buffer
+            buffer.push_back(std::move(*local)); // Inserta el ítem en el buffer
+            sequence = logger.reserve(); // Ordena el evento respecto de los demás accesos al buffer
+            depth = static_cast<int>(buffer.size());
+            buffer_mutex.release(); // Libera el semáforo después de modificar el buffer
+        }
+        if (mode == BufferMode::Semaforo || mode == BufferMode::MPMC) {
+            items.release(); // Indica que hay un nuevo ítem disponible
+        }
+        logger.logEvent(sequence, EventType::Insercion, id, item_id, depth);
+    }
+
+    // Libera la posición de un ítem tomado con peek() (modos MPMC, SPSC y Carriles)
+    void releasePeeked(size_t pos, MPMCRing<Slot<T>>* lane) {
+        if (mode == BufferMode::SPSC) {
+            spsc.release(pos);
+        } else {
+            lane->release(pos);
+            if (mode == BufferMode::MPMC) {
+                spaces.release(); // Indica que hay un espacio disponible en el buffer
+            }
+        }
+    }
+
+    // Toma entre 1 y `wanted` espacios: todos los libres si hay alguno, y si no espera el primero
+    size_t acquireSpaces(size_t wanted) {
+        if (mode == BufferMode::SPSC) {
+            if (spsc.full()) {
+                producer_waits.fetch_add(1, memory_order_relaxed);
+                retryUntil([&] { return !spsc.full(); }, NO_DEADLINE, wait, &producer_spin);
+            }
+            return min(wanted, spsc.freeSpace());  // Con un solo productor el espacio libre solo puede crecer
+        }
+        size_t count = spaces.tryAcquireUpTo(wanted);
+        if (count == 0) {
+            producer_waits.fetch_add(1, memory_order_relaxed);  // Se cuenta la espera en lugar de registrarla
+            spaces.acquire();
+            count = 1 + spaces.tryAcquireUpTo(wanted - 1);
+        }
+        return count;
+    }
+
+    // Inserta un lote para el que ya se tomaron los espacios
+    void insertBatch(int id, span<T> batch) {
+        array<int64_t, MAX_BATCH> ids;  // Identificadores para el log, leídos antes de mover los ítems
+        for (size_t j = 0; j < batch.size(); ++j) {
+            ids[j] = eventItemId(batch[j]);
+        }
+        uint64_t sequence;
+        int depth;  // Ítems en el buffer después de la vuelta
+        uint64_t enqueued_ns = elapsedNanoseconds();
+        if (mode == BufferMode::SPSC || mode == BufferMode::MPMC) {
+            // Secuencias reservadas antes de publicar, como en emplaceUntil()
+            sequence = logger.reserve(batch.size());
+            for (T& item : batch) {
+                if (mode == BufferMode::SPSC) {
+                    spsc.tryEmplace(enqueued_ns, std::move(item));
+                } else {
+                    while (!ring.tryEmplace(enqueued_ns, std::move(item))) {
+                        this_thread::yield();
+                    }
+                }
+            }
+            depth = static_cast<int>(mode == BufferMode::SPSC ? spsc.size() : ring.size());
+        } else {
+            buffer_mutex.acquire(); // Una sola toma del candado para todo el lote
+            for (T& item : batch) {
+                buffer.emplace_back(enqueued_ns, std::move(item));
+            }
+            sequence = logger.reserve(batch.size()); // Secuencias contiguas para los eventos del lote
+            depth = static_cast<int>(buffer.size());
+            buffer_mutex.release();
+        }
+        if (mode != BufferMode::SPSC) {
+            items.release(batch.size()); // Indica que hay `batch.size()` ítems nuevos
+        }
+        for (size_t j = 0; j < batch.size(); ++j) {
+            logger.logEvent(sequence + j, EventType::Insercion, id, ids[j], depth - static_cast<int>(batch.size() - j - 1));
+        }
+    }
+
+public:
+
+    // Registra el tiempo entre la inserción y el consumo de un ítem
+    static void recordLatency(const Slot<T>& slot, LatencyHistogram* latency) {
+        if (latency != nullptr) {
+            latency->record(elapsedNanoseconds() - slot.enqueued_ns);
+        }
+    }
+
+    // Método para mostrar los ítems restantes en el buffer (por su identificador de log)
+    void showRemainingItems() {
+        buffer_mutex.acquire(); // Adquiere el semáforo para acceder al buffer
+        std::stringstream ss;  // Crear un stringstream para construir el mensaje
+        ss << "Elementos restantes en el buffer: "; // Mensaje de inicio
+        bool empty = true;
+        auto show = [&](const Slot<T>& slot) {
+            ss << eventItemId(slot.item) << " "; // Agrega cada ítem al mensaje
+            empty = false;
+        };
+        if (mode == BufferMode::MPMC) {
+            ring.forEach(show); // Los hilos ya terminaron, el anillo está quieto
+        } else if (mode == BufferMode::SPSC) {
+            spsc.forEach(show); // Los hilos ya terminaron, el anillo está quieto
+        } else if (mode == BufferMode::Carriles) {
+            for (const auto& lane : lanes) {
+                lane->forEach(show); // Los hilos ya terminaron, los carriles están quietos
+            }
+        } else {
+            for (const Slot<T>& slot : buffer) { // Recorre la cola en orden
+                show(slot);
+            }
+        }
+        if (empty) { // Verifica si el buffer está vacío
+            ss << "El buffer está vacío.\n"; // Mensaje si el buffer está vacío
+        } else {
+            ss << "\n"; // Salto de línea al final
+        }
+        printMessage(ss.str()); // Llama a la función para imprimir y escribir en el archivo
+        buffer_mutex.release(); // Libera el semáforo después de mostrar los ítems
+    }
+};
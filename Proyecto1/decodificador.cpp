@@ -0,0 +1,64 @@
+#include <iostream>  // Librería para imprimir en consola
+#include <fstream>   // Librería para manejar archivos
+#include <string>    // Librería para manejar cadenas de texto
+#include <cstring>   // Librería para comparar memoria (memcmp)
+
+#include "eventos.h" // Formato del log binario y texto de cada evento
+
+using namespace std;
+
+// Decodificador del log binario de Proyecto1 (producer-consumer.bin).
+// Reproduce el texto de producer-consumer.txt o genera una tabla CSV de los eventos para análisis
+// (la tabla omite los mensajes de texto libre, que no tienen marca de tiempo).
+int main(int argc, char* argv[]) {
+    // Verifica que se proporcionen los parámetros correctos
+    if (argc < 2 || argc > 3 || (argc == 3 && string(argv[2]) != "--csv")) {
+        cout << "Uso: " << argv[0] << " <archivo.bin> [--csv]" << endl;
+        return 1; // Retorna 1 si el número de argumentos es incorrecto
+    }
+
+    ifstream input(argv[1], ios::binary);
+    if (!input) {
+        cerr << "No se pudo abrir el archivo " << argv[1] << ".\n"; // Mensaje de error
+        return 1;
+    }
+
+    // Verifica la cabecera del archivo
+    char magic[sizeof(BINARY_LOG_MAGIC)];
+    if (!input.read(magic, sizeof(magic)) || memcmp(magic, BINARY_LOG_MAGIC, sizeof(magic)) != 0) {
+        cerr << "El archivo " << argv[1] << " no es un log binario de Proyecto1.\n"; // Mensaje de error
+        return 1;
+    }
+
+    bool csv = argc == 3;
+    if (csv) {
+        cout << "timestamp_ns,evento,actor,item,profundidad\n"; // Encabezado de la tabla
+    }
+
+    // Lee y escribe cada registro
+    BinaryLogDecoder decoder(input);
+    EventRecord event;
+    string text;
+    BinaryLogDecoder::Status status;
+    while ((status = decoder.next(event, text)) == BinaryLogDecoder::Status::Registro) {
+        if (event.type == EventType::Texto) {
+            if (!csv) {
+                cout << text;
+            }
+        } else if (csv) {
+            cout << event.timestamp_ns << ',' << eventName(event.type) << ',' << event.actor << ','
+                 << event.item << ',' << event.depth << '\n';
+        } else {
+            MessageBuilder message;
+            formatEvent(message, event);
+            cout << message.view();
+        }
+    }
+
+    // Un registro incompleto indica que el archivo fue truncado
+    if (status == BinaryLogDecoder::Status::Invalido) {
+        cerr << "El archivo termina con un registro incompleto o inválido.\n"; // Mensaje de error
+        return 1;
+    }
+    return 0;
+}
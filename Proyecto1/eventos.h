@@ -0,0 +1,230 @@
+// Definiciones compartidas por Proyecto1 y el decodificador del log binario
+#pragma once
+
+#include <charconv>    // Librería para convertir números a texto sin memoria dinámica (to_chars)
+#include <concepts>    // Librería para restringir plantillas (integral)
+#include <cstdint>     // Librería para enteros de tamaño fijo
+#include <cstring>     // Librería para copiar memoria (memcpy)
+#include <algorithm>   // Librería para algoritmos (min)
+#include <istream>     // Librería para leer el log binario
+#include <string>      // Librería para acumular registros del log binario
+#include <string_view> // Librería para pasar mensajes sin copiarlos
+
+const std::size_t MESSAGE_CAPACITY = 212;  // Bytes máximos de un mensaje corto (cabe en un registro del log)
+
+// Tipos de evento que se registran en el log
+enum class EventType : std::uint32_t {
+    Texto,               // Mensaje de texto libre
+    Insercion,           // Un productor insertó un ítem
+    Consumo,             // Un consumidor tomó un ítem
+    ProductorCreado,     // Un productor comenzó
+    ProductorTerminado,  // Un productor terminó
+    ConsumidorCreado,    // Un consumidor comenzó
+    ConsumidorTerminado, // Un consumidor terminó
+    Robo,                // Un consumidor robó un ítem del deque local de otro
+    Descarte             // Un productor descartó un ítem por la política de desborde
+};
+
+// Evento registrado (los campos que no aplican al evento valen -1)
+struct EventRecord {
+    std::uint64_t timestamp_ns;  // Nanosegundos desde el inicio del programa
+    std::int64_t item;           // Ítem involucrado
+    std::int32_t actor;          // Identificador del productor o consumidor
+    std::int32_t depth;          // Ítems en el buffer después del evento
+    EventType type;              // Tipo de evento
+};
+
+// Cabecera del archivo binario, seguida de los registros en orden de ocurrencia. Cada registro
+// empieza con un byte con el tipo de evento. Un registro de texto sigue con la longitud y los bytes
+// del texto; los demás, con la diferencia entre su marca de tiempo y la del evento anterior, el
+// productor o consumidor, el ítem y los ítems en el buffer. Los números se guardan con longitud
+// variable (7 bits por byte, y los que llevan signo en zigzag), así que un evento típico ocupa
+// entre 5 y 10 bytes
+const char BINARY_LOG_MAGIC[8] = {'P', 'C', 'L', 'O', 'G', 'B', '0', '2'};
+
+// Escribe registros del log binario; recuerda la marca de tiempo anterior para guardar solo la diferencia
+class BinaryLogEncoder {
+private:
+    std::uint64_t previous_ns = 0;  // Marca de tiempo del evento anterior
+
+    // Entero sin signo: 7 bits por byte, el bit alto indica que sigue otro byte
+    static void appendVarint(std::string& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    // Entero con signo en zigzag (0, -1, 1, -2, ...) para que los valores cercanos a cero ocupen un byte
+    static void appendSigned(std::string& out, std::int64_t value) {
+        appendVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+public:
+    // Agrega un evento a `out`
+    void event(std::string& out, const EventRecord& event) {
+        out.push_back(static_cast<char>(event.type));
+        // Los eventos se escriben en orden de secuencia, que puede no coincidir con el de sus marcas de tiempo
+        appendSigned(out, static_cast<std::int64_t>(event.timestamp_ns - previous_ns));
+        previous_ns = event.timestamp_ns;
+        appendSigned(out, event.actor);
+        appendSigned(out, event.item);
+        appendSigned(out, event.depth);
+    }
+
+    // Agrega un fragmento de texto libre a `out`
+    void text(std::string& out, std::string_view text) {
+        out.push_back(static_cast<char>(EventType::Texto));
+        appendVarint(out, text.size());
+        out.append(text);
+    }
+};
+
+// Lee los registros del log binario escritos por BinaryLogEncoder
+class BinaryLogDecoder {
+private:
+    std::istream& input;            // Archivo, ya posicionado después de la cabecera
+    std::uint64_t previous_ns = 0;  // Marca de tiempo del evento anterior
+
+    bool readVarint(std::uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            int byte = input.get();
+            if (byte == std::char_traits<char>::eof()) {
+                return false;
+            }
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool readSigned(std::int64_t& value) {
+        std::uint64_t raw;
+        if (!readVarint(raw)) {
+            return false;
+        }
+        value = static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+        return true;
+    }
+
+public:
+    enum class Status {
+        Registro,  // Se leyó un registro
+        Fin,       // No quedan registros
+        Invalido   // El archivo termina a mitad de un registro o tiene un tipo desconocido
+    };
+
+    explicit BinaryLogDecoder(std::istream& input) : input(input) {}
+
+    // Lee el próximo registro en `event`; si es de texto (event.type es Texto), el texto queda en `text`
+    Status next(EventRecord& event, std::string& text) {
+        int type = input.get();
+        if (type == std::char_traits<char>::eof()) {
+            return Status::Fin;
+        }
+        if (type > static_cast<int>(EventType::Descarte)) {
+            return Status::Invalido;
+        }
+        event.type = static_cast<EventType>(type);
+        if (event.type == EventType::Texto) {
+            std::uint64_t length;
+            if (!readVarint(length)) {
+                return Status::Invalido;
+            }
+            text.resize(length);
+            return input.read(text.data(), static_cast<std::streamsize>(length)) ? Status::Registro : Status::Invalido;
+        }
+        std::int64_t delta, actor, item, depth;
+        if (!readSigned(delta) || !readSigned(actor) || !readSigned(item) || !readSigned(depth)) {
+            return Status::Invalido;
+        }
+        previous_ns += static_cast<std::uint64_t>(delta);
+        event = EventRecord{previous_ns, item, static_cast<std::int32_t>(actor), static_cast<std::int32_t>(depth), event.type};
+        return Status::Registro;
+    }
+};
+
+// Construye un mensaje corto en un arreglo fijo en la pila, sin memoria dinámica ni consultas
+// al locale como std::stringstream; los números se convierten con std::to_chars.
+// El texto que no cabe en MESSAGE_CAPACITY se descarta.
+class MessageBuilder {
+private:
+    char data[MESSAGE_CAPACITY];  // Texto del mensaje
+    std::size_t length = 0;       // Bytes usados en `data`
+
+public:
+    // Agrega texto al mensaje
+    MessageBuilder& operator<<(std::string_view text) {
+        std::size_t count = std::min(text.size(), sizeof(data) - length);
+        std::memcpy(data + length, text.data(), count);
+        length += count;
+        return *this;
+    }
+
+    // Agrega un número entero al mensaje
+    template <std::integral Number>
+    MessageBuilder& operator<<(Number value) {
+        auto result = std::to_chars(data + length, data + sizeof(data), value);
+        if (result.ec == std::errc()) {
+            length = result.ptr - data;
+        }
+        return *this;
+    }
+
+    // Retorna el mensaje construido
+    std::string_view view() const {
+        return std::string_view(data, length);
+    }
+};
+
+// Escribe el texto de un evento tal como aparece en producer-consumer.txt
+inline void formatEvent(MessageBuilder& message, const EventRecord& event) {
+    switch (event.type) {
+    case EventType::Insercion:
+        message << "Inserción exitosa\n" << "Productor " << event.actor << " produjo: " << event.item << "\n";
+        break;
+    case EventType::Consumo:
+        message << "Consumidor " << event.actor << " consumió: " << event.item << "\n";
+        break;
+    case EventType::ProductorCreado:
+        message << "Productor " << event.actor << " creado.\n";
+        break;
+    case EventType::ProductorTerminado:
+        message << "Productor " << event.actor << " ha terminado.\n";
+        break;
+    case EventType::ConsumidorCreado:
+        message << "Consumidor " << event.actor << " creado.\n";
+        break;
+    case EventType::ConsumidorTerminado:
+        message << "Consumidor " << event.actor << " ha terminado.\n";
+        break;
+    case EventType::Robo:
+        message << "Consumidor " << event.actor << " robó: " << event.item << "\n";
+        break;
+    case EventType::Descarte:
+        message << "Productor " << event.actor << " descartó: " << event.item << "\n";
+        break;
+    case EventType::Texto:
+        break;
+    }
+}
+
+// Nombre corto del tipo de evento (usado en la salida CSV)
+inline const char* eventName(EventType type) {
+    switch (type) {
+    case EventType::Texto: return "texto";
+    case EventType::Insercion: return "insercion";
+    case EventType::Consumo: return "consumo";
+    case EventType::ProductorCreado: return "productor_creado";
+    case EventType::ProductorTerminado: return "productor_terminado";
+    case EventType::ConsumidorCreado: return "consumidor_creado";
+    case EventType::ConsumidorTerminado: return "consumidor_terminado";
+    case EventType::Robo: return "robo";
+    case EventType::Descarte: return "descarte";
+    }
+    return "desconocido";
+}
@@ -0,0 +1,130 @@
+// Microbenchmark de falso compartir con el patrón de acceso del Buffer de Proyecto1: los productores
+// toman un permiso de `spaces` y devuelven uno a `items`, y los consumidores toman de `items` y
+// devuelven a `spaces`, así que los dos lados escriben los dos contadores. Se compara la disposición
+// contigua (los dos semáforos en la misma línea de caché) con la que usa Buffer, donde cada semáforo
+// empieza en su propia línea: las líneas siguen pasando de un núcleo a otro, pero cada operación
+// compite solo con las que tocan el mismo semáforo y no con todas.
+#include <iostream>  // Librería para imprimir en consola
+#include <thread>    // Librería para usar hilos
+#include <vector>    // Librería para usar vectores
+#include <chrono>    // Librería para medir tiempo
+#include <atomic>    // Librería para contadores atómicos
+#include <new>       // Librería para el tamaño de interferencia (hardware_destructive_interference_size)
+#include <cstdlib>   // Librería para convertir texto a números (atoi)
+#include <cstddef>   // Librería para ptrdiff_t
+
+using namespace std;
+
+// Distancia mínima entre datos que escriben hilos distintos (igual que en buffer.h)
+#ifdef __cpp_lib_hardware_interference_size
+const size_t CACHE_LINE_SIZE = hardware_destructive_interference_size;
+#else
+const size_t CACHE_LINE_SIZE = 64;  // Tamaño de línea de caché habitual cuando la librería no lo informa
+#endif
+
+// Parte de ClosableSemaphore que se toca sin dormir: el contador de permisos y los hilos en espera,
+// que release() lee para decidir si hay que despertar a alguien
+struct Semaphore {
+    atomic<ptrdiff_t> count;
+    atomic<int> waiters{0};
+
+    explicit Semaphore(ptrdiff_t initial) : count(initial) {}
+
+    // Toma un permiso como tryAcquire(); sin permisos relee el contador y cada tanto cede el núcleo
+    void acquire() {
+        for (int attempt = 1;; ++attempt) {
+            ptrdiff_t current = count.load();
+            if (current > 0 && count.compare_exchange_weak(current, current - 1)) {
+                return;
+            }
+            if (attempt % 64 == 0) {
+                this_thread::yield();  // Con más hilos que núcleos, deja correr al otro lado
+            }
+        }
+    }
+
+    // Devuelve un permiso como release()
+    void release() {
+        count.fetch_add(1);
+        (void)waiters.load();  // release() lo lee para despertar a un hilo dormido; aquí nadie duerme
+    }
+};
+
+// Los dos semáforos seguidos, en la misma línea de caché
+struct PackedSemaphores {
+    Semaphore spaces;
+    Semaphore items{0};
+
+    explicit PackedSemaphores(ptrdiff_t capacity) : spaces(capacity) {}
+};
+
+// Los dos semáforos alineados cada uno a su propia línea, como en Buffer
+struct PaddedSemaphores {
+    alignas(CACHE_LINE_SIZE) Semaphore spaces;
+    alignas(CACHE_LINE_SIZE) Semaphore items{0};
+
+    explicit PaddedSemaphores(ptrdiff_t capacity) : spaces(capacity) {}
+};
+
+// Lanza los productores y consumidores, que pasan `per_producer` ítems cada productor por un buffer
+// de `capacity` espacios (solo los permisos, sin datos), y retorna los nanosegundos por ítem
+template <typename Semaphores>
+double measure(int producers, int consumers, uint64_t per_producer, ptrdiff_t capacity) {
+    Semaphores semaphores(capacity);
+    uint64_t total = per_producer * producers;
+    atomic<int> ready{0};
+    int threads = producers + consumers;
+    auto waitForAll = [&] {
+        ready.fetch_add(1);
+        while (ready.load() < threads) {
+            this_thread::yield();  // Esperar a que todos los hilos estén listos para que compitan durante toda la medición
+        }
+    };
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (int p = 0; p < producers; ++p) {
+        workers.emplace_back([&] {
+            waitForAll();
+            for (uint64_t i = 0; i < per_producer; ++i) {
+                semaphores.spaces.acquire();  // Espacio libre para insertar
+                semaphores.items.release();   // Ítem disponible para los consumidores
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        // Cada consumidor toma su parte del total; los primeros se quedan con el resto de la división
+        uint64_t quota = total / consumers + (static_cast<uint64_t>(c) < total % consumers ? 1 : 0);
+        workers.emplace_back([&, quota] {
+            waitForAll();
+            for (uint64_t i = 0; i < quota; ++i) {
+                semaphores.items.acquire();   // Ítem para consumir
+                semaphores.spaces.release();  // Espacio libre para los productores
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    return static_cast<double>(elapsed) / static_cast<double>(total);
+}
+
+int main(int argc, char* argv[]) {
+    int producers = argc > 1 ? atoi(argv[1]) : 1;
+    int consumers = argc > 2 ? atoi(argv[2]) : 1;
+    uint64_t per_producer = argc > 3 ? strtoull(argv[3], nullptr, 10) : 10000000;
+    ptrdiff_t capacity = argc > 4 ? atoi(argv[4]) : 256;
+    if (producers < 1 || consumers < 1 || per_producer == 0 || capacity < 1) {
+        cerr << "Uso: " << argv[0] << " [productores] [consumidores] [ítems por productor] [capacidad]\n";
+        return 1;
+    }
+
+    cout << "Productores: " << producers << ", consumidores: " << consumers << ", ítems por productor: " << per_producer
+         << ", capacidad: " << capacity << ", línea de caché: " << CACHE_LINE_SIZE << " bytes\n";
+    double packed = measure<PackedSemaphores>(producers, consumers, per_producer, capacity);
+    double padded = measure<PaddedSemaphores>(producers, consumers, per_producer, capacity);
+    cout << "Semáforos contiguos (comparten línea): " << packed << " ns por ítem\n";
+    cout << "Semáforos alineados (una línea cada uno): " << padded << " ns por ítem\n";
+    cout << "Aceleración por separar los semáforos: " << packed / padded << "x\n";
+    return 0;
+}
@@ -0,0 +1,418 @@
+// Benchmark de rendimiento del Buffer de Proyecto1: recorre una grilla de capacidades, cantidades de
+// productores y consumidores y tamaños de ítem; cada punto se ejecuta con corridas de calentamiento
+// y varias repeticiones, y se informan los ítems por segundo y la latencia en el buffer en CSV, JSON
+// o como tabla comparativa. Con --comparar, cada punto se ejecuta con todas las implementaciones
+// del buffer y con una cola clásica de mutex y variables de condición como línea base. Con
+// --insercion, los ítems se construyen directamente en el buffer (emplace) o se escriben y leen en
+// su memoria sin copias (claim/publish y peek/release) en lugar de moverse hacia y desde el buffer.
+// El registro de eventos se desactiva para medir solo el buffer.
+#include <iostream>  // Librería para imprimir en consola
+#include <thread>    // Librería para usar hilos
+#include <vector>    // Librería para usar vectores
+#include <chrono>    // Librería para medir tiempo
+#include <latch>     // Librería para largar todos los hilos a la vez (latch)
+#include <mutex>     // Librería para usar mutex (cola de referencia)
+#include <condition_variable> // Librería para esperar espacio o ítems (cola de referencia)
+#include <deque>     // Librería para colas de doble extremo (cola de referencia)
+#include <optional>  // Librería para valores opcionales (resultado de consumir)
+#include <iomanip>   // Librería para alinear columnas (setw)
+#include <string>    // Librería para manejar cadenas de texto
+#include <algorithm> // Librería para algoritmos (sort)
+#include <cstdlib>   // Librería para convertir texto a números (strtol)
+
+#include "buffer.h"  // Buffer compartido con Proyecto1
+
+using namespace std;
+
+// Ítem de `Bytes` bytes: un identificador (que el buffer usa como identificador del ítem) y relleno
+template <size_t Bytes>
+struct Payload {
+    int64_t id;
+    array<char, Bytes - sizeof(int64_t)> data{};
+};
+template <>
+struct Payload<sizeof(int64_t)> {
+    int64_t id;
+};
+
+// Cola acotada clásica con std::mutex y dos variables de condición (una para esperar espacio y otra
+// para esperar ítems), con la misma interfaz que usa el benchmark del Buffer. Sirve de línea base
+template <typename T>
+class MutexQueue {
+private:
+    mutex queue_mutex;               // Protege la cola y el indicador de cierre
+    condition_variable not_full;     // Avisa a los productores que se liberó un espacio
+    condition_variable not_empty;    // Avisa a los consumidores que hay un ítem o que se cerró la cola
+    deque<Slot<T>> items;            // Ítems con su marca de tiempo de inserción
+    size_t capacity;                 // Máximo de ítems en la cola
+    bool closed = false;             // Los productores terminaron
+
+public:
+    explicit MutexQueue(int capacity) : capacity(capacity) {}
+
+    // Inserta un ítem; espera mientras la cola esté llena
+    void produce(int, T item) {
+        unique_lock<mutex> lock(queue_mutex);
+        not_full.wait(lock, [&] { return items.size() < capacity; });
+        items.emplace_back(elapsedNanoseconds(), std::move(item));
+        lock.unlock();
+        not_empty.notify_one();
+    }
+
+    // Construye un ítem al final de la cola a partir de `args`; espera mientras la cola esté llena
+    template <typename... Args>
+    void emplace(int, Args&&... args) {
+        unique_lock<mutex> lock(queue_mutex);
+        not_full.wait(lock, [&] { return items.size() < capacity; });
+        items.emplace_back(elapsedNanoseconds(), forward<Args>(args)...);
+        lock.unlock();
+        not_empty.notify_one();
+    }
+
+    // Toma un ítem; espera mientras la cola esté vacía y retorna un valor vacío si está cerrada y vacía
+    optional<T> consume(int, stop_token = {}, LatencyHistogram* latency = nullptr) {
+        unique_lock<mutex> lock(queue_mutex);
+        not_empty.wait(lock, [&] { return !items.empty() || closed; });
+        if (items.empty()) {
+            return nullopt;
+        }
+        Slot<T> slot = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        not_full.notify_one();
+        if (latency != nullptr) {
+            latency->record(elapsedNanoseconds() - slot.enqueued_ns);
+        }
+        return std::move(slot.item);
+    }
+
+    // Indica que no se producirán más ítems y despierta a los consumidores en espera
+    void close() {
+        {
+            lock_guard<mutex> lock(queue_mutex);
+            closed = true;
+        }
+        not_empty.notify_all();
+    }
+};
+
+// Implementación de cola que se mide
+struct Backend {
+    const char* name;   // Nombre en la salida y en --buffer
+    bool mutex_queue;   // true para la cola de referencia MutexQueue
+    BufferMode mode;    // Modo del Buffer (si no es la cola de referencia)
+};
+const Backend BACKENDS[] = {
+    {"semaforo", false, BufferMode::Semaforo},
+    {"mutex", true, BufferMode::Semaforo},
+    {"mpmc", false, BufferMode::MPMC},
+    {"spsc", false, BufferMode::SPSC},
+    {"carriles", false, BufferMode::Carriles},
+    {"auto", false, BufferMode::Automatico},
+};
+
+// Configuración de la grilla (modificable por línea de comandos)
+vector<int> CAPACITIES = {16, 256};  // Capacidades del buffer (--capacidades)
+vector<int> PRODUCERS = {1, 2, 4};   // Cantidades de productores (--productores)
+vector<int> CONSUMERS = {1, 2, 4};   // Cantidades de consumidores (--consumidores)
+vector<int> PAYLOADS = {8, 64};      // Tamaños de ítem en bytes (--bytes): 8, 64, 256, 1024 o 4096
+int ITEMS = 100000;                  // Ítems que inserta cada productor en cada corrida (--items)
+int WARMUP = 1;                      // Corridas descartadas antes de medir cada punto (--calentamiento)
+int REPETITIONS = 5;                 // Corridas medidas de cada punto (--repeticiones)
+vector<Backend> SELECTED = {BACKENDS[5]};  // Implementaciones a medir (--buffer o --comparar)
+enum class Format { CSV, JSON, Tabla };
+Format FORMAT = Format::CSV;         // Formato de salida (--formato); --comparar usa la tabla por defecto
+// Cómo pasan los ítems por el buffer (--insercion): se mueven con produce/consume, se construyen en
+// el buffer con emplace, o se escriben y leen en la memoria del buffer con claim/peek
+enum class Insertion { Mover, Construir, EnElLugar };
+Insertion INSERTION = Insertion::Mover;
+const char* const INSERTION_NAMES[] = {"mover", "construir", "en-el-lugar"};
+
+// Resultado de un punto de la grilla
+struct PointResult {
+    const char* backend;
+    int bytes, capacity, producers, consumers;
+    double median, min, max;      // Ítems por segundo de las repeticiones
+    LatencyHistogram latency;     // Latencias de todas las repeticiones juntas
+};
+
+// Ejecuta una corrida sobre `buffer`: `producers` hilos insertan ITEMS ítems cada uno y `consumers`
+// hilos consumen hasta que el buffer se cierra y queda vacío. La carga es idéntica para todas las
+// implementaciones. Retorna los ítems por segundo y suma las latencias a `latency`.
+// La cola de referencia no tiene claim/peek: con --insercion=en-el-lugar no se mide (ver main)
+template <size_t Bytes, typename Queue>
+double drive(Queue& buffer, int producers, int consumers, LatencyHistogram& latency) {
+    vector<LatencyHistogram> latencies(consumers);  // Un histograma por consumidor, sin compartir
+    latch ready(producers + consumers + 1);  // Todos los hilos empiezan a la vez que el cronómetro
+    vector<thread> producer_threads;
+    vector<thread> consumer_threads;
+    for (int p = 0; p < producers; ++p) {
+        producer_threads.emplace_back([&, p] {
+            ready.arrive_and_wait();
+            for (int i = 0; i < ITEMS; ++i) {
+                int64_t id = static_cast<int64_t>(p) * ITEMS + i;
+                if constexpr (requires { buffer.claim(p); }) {
+                    if (INSERTION == Insertion::EnElLugar) {
+                        auto slot = buffer.claim(p + 1);  // El ítem se escribe en la memoria del buffer
+                        slot->id = id;
+                        continue;  // Se publica al destruir slot
+                    }
+                }
+                if (INSERTION == Insertion::Construir) {
+                    buffer.emplace(p + 1, id);
+                } else {
+                    buffer.produce(p + 1, Payload<Bytes>{id});
+                }
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        consumer_threads.emplace_back([&, c] {
+            ready.arrive_and_wait();
+            if constexpr (requires { buffer.peek(c); }) {
+                if (INSERTION == Insertion::EnElLugar) {
+                    // El ítem se lee en el lugar y su espacio se libera al destruir slot
+                    while (auto slot = buffer.peek(c + 1, {}, &latencies[c])) {
+                    }
+                    return;
+                }
+            }
+            while (buffer.consume(c + 1, {}, &latencies[c])) {
+            }
+        });
+    }
+    ready.arrive_and_wait();
+    auto start = chrono::steady_clock::now();
+    for (auto& t : producer_threads) {
+        t.join();
+    }
+    buffer.close();
+    for (auto& t : consumer_threads) {
+        t.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    for (const auto& histogram : latencies) {
+        latency.merge(histogram);
+    }
+    return static_cast<double>(producers) * ITEMS / seconds;
+}
+
+// Ejecuta una corrida con una cola nueva de la implementación `backend`
+template <size_t Bytes>
+double runOnce(const Backend& backend, int capacity, int producers, int consumers, LatencyHistogram& latency) {
+    if (backend.mutex_queue) {
+        MutexQueue<Payload<Bytes>> queue(capacity);
+        return drive<Bytes>(queue, producers, consumers, latency);
+    }
+    Buffer<Payload<Bytes>> buffer(capacity, resolveBufferMode(backend.mode, producers, consumers), producers);
+    return drive<Bytes>(buffer, producers, consumers, latency);
+}
+
+// Ejecuta un punto de la grilla con calentamiento y repeticiones
+template <size_t Bytes>
+PointResult runPoint(const Backend& backend, int capacity, int producers, int consumers) {
+    PointResult result{backend.name, static_cast<int>(Bytes), capacity, producers, consumers, 0, 0, 0, {}};
+    LatencyHistogram discarded;
+    for (int r = 0; r < WARMUP; ++r) {
+        runOnce<Bytes>(backend, capacity, producers, consumers, discarded);
+    }
+    vector<double> rates;
+    for (int r = 0; r < REPETITIONS; ++r) {
+        rates.push_back(runOnce<Bytes>(backend, capacity, producers, consumers, result.latency));
+    }
+    sort(rates.begin(), rates.end());
+    result.median = rates.size() % 2 == 1 ? rates[rates.size() / 2] : (rates[rates.size() / 2 - 1] + rates[rates.size() / 2]) / 2;
+    result.min = rates.front();
+    result.max = rates.back();
+    return result;
+}
+
+// Elige la instancia de runPoint según el tamaño de ítem
+PointResult runPoint(const Backend& backend, int bytes, int capacity, int producers, int consumers) {
+    switch (bytes) {
+    case 8: return runPoint<8>(backend, capacity, producers, consumers);
+    case 64: return runPoint<64>(backend, capacity, producers, consumers);
+    case 256: return runPoint<256>(backend, capacity, producers, consumers);
+    case 1024: return runPoint<1024>(backend, capacity, producers, consumers);
+    default: return runPoint<4096>(backend, capacity, producers, consumers);
+    }
+}
+
+// Escribe un resultado como fila CSV o como objeto JSON (la tabla se escribe por escenario)
+void printResult(const PointResult& result, bool first) {
+    const LatencyHistogram& latency = result.latency;
+    if (FORMAT == Format::JSON) {
+        cout << (first ? "  " : ",\n  ") << "{\"buffer\": \"" << result.backend << "\", \"insercion\": \""
+             << INSERTION_NAMES[static_cast<int>(INSERTION)] << "\", \"bytes\": " << result.bytes << ", \"capacidad\": " << result.capacity
+             << ", \"productores\": " << result.producers << ", \"consumidores\": " << result.consumers
+             << ", \"items_por_s\": " << static_cast<uint64_t>(result.median)
+             << ", \"items_por_s_min\": " << static_cast<uint64_t>(result.min)
+             << ", \"items_por_s_max\": " << static_cast<uint64_t>(result.max)
+             << ", \"latencia_p50_ns\": " << latency.percentile(50) << ", \"latencia_p99_ns\": " << latency.percentile(99)
+             << ", \"latencia_p999_ns\": " << latency.percentile(99.9) << ", \"latencia_max_ns\": " << latency.maxValue() << "}";
+    } else {
+        cout << result.backend << ',' << INSERTION_NAMES[static_cast<int>(INSERTION)] << ',' << result.bytes << ',' << result.capacity << ',' << result.producers << ',' << result.consumers << ','
+             << static_cast<uint64_t>(result.median) << ',' << static_cast<uint64_t>(result.min) << ','
+             << static_cast<uint64_t>(result.max) << ',' << latency.percentile(50) << ',' << latency.percentile(99) << ','
+             << latency.percentile(99.9) << ',' << latency.maxValue() << '\n';
+    }
+    cout.flush();  // Cada punto aparece apenas termina
+}
+
+// Escribe la cabecera de la tabla comparativa: una columna de ítems por segundo por implementación
+void printTableHeader() {
+    cout << "Ítems por segundo (mediana) y latencia p99 en µs entre paréntesis; * marca la más rápida (inserción: "
+         << INSERTION_NAMES[static_cast<int>(INSERTION)] << ")\n";
+    cout << setw(6) << "bytes" << setw(8) << "cap" << setw(4) << "P" << setw(4) << "C" << " |";
+    for (const Backend& backend : SELECTED) {
+        cout << setw(20) << backend.name;
+    }
+    cout << '\n';
+}
+
+// Escribe una fila de la tabla con los resultados de todas las implementaciones para un escenario
+// (las que no aplican al escenario, como spsc con varios hilos o mutex con --insercion=en-el-lugar,
+// quedan con un guion)
+void printTableRow(const vector<optional<PointResult>>& row) {
+    const PointResult& any = **find_if(row.begin(), row.end(), [](const auto& result) { return result.has_value(); });
+    double best = 0;
+    for (const auto& result : row) {
+        if (result) {
+            best = max(best, result->median);
+        }
+    }
+    cout << setw(6) << any.bytes << setw(8) << any.capacity << setw(4) << any.producers << setw(4) << any.consumers << " |";
+    for (const auto& result : row) {
+        string cell = "-";
+        if (result) {
+            cell = to_string(static_cast<uint64_t>(result->median)) + " (" +
+                   to_string(result->latency.percentile(99) / 1000) + ")" + (result->median == best ? "*" : " ");
+        }
+        cout << setw(20) << cell;
+    }
+    cout << '\n';
+    cout.flush();  // Cada escenario aparece apenas termina
+}
+
+// Interpreta una lista de enteros positivos separados por comas
+bool parseList(const string& text, vector<int>& values) {
+    values.clear();
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        string number = text.substr(start, comma == string::npos ? string::npos : comma - start);
+        char* end = nullptr;
+        long value = strtol(number.c_str(), &end, 10);
+        if (number.empty() || *end != '\0' || value < 1) {
+            return false;
+        }
+        values.push_back(static_cast<int>(value));
+        if (comma == string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return !values.empty();
+}
+
+int main(int argc, char* argv[]) {
+    bool format_given = false;  // --formato tiene prioridad sobre el formato por defecto de --comparar
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        string value = option.substr(option.find('=') + 1);
+        bool valid = true;
+        if (option.rfind("--capacidades=", 0) == 0) {
+            valid = parseList(value, CAPACITIES);
+        } else if (option.rfind("--productores=", 0) == 0) {
+            valid = parseList(value, PRODUCERS);
+        } else if (option.rfind("--consumidores=", 0) == 0) {
+            valid = parseList(value, CONSUMERS);
+        } else if (option.rfind("--bytes=", 0) == 0) {
+            valid = parseList(value, PAYLOADS) && all_of(PAYLOADS.begin(), PAYLOADS.end(), [](int bytes) {
+                return bytes == 8 || bytes == 64 || bytes == 256 || bytes == 1024 || bytes == 4096;
+            });
+        } else if (option.rfind("--items=", 0) == 0) {
+            ITEMS = atoi(value.c_str());
+            valid = ITEMS > 0;
+        } else if (option.rfind("--calentamiento=", 0) == 0) {
+            WARMUP = atoi(value.c_str());
+            valid = WARMUP >= 0 && value.find_first_not_of("0123456789") == string::npos;
+        } else if (option.rfind("--repeticiones=", 0) == 0) {
+            REPETITIONS = atoi(value.c_str());
+            valid = REPETITIONS > 0;
+        } else if (option.rfind("--buffer=", 0) == 0) {
+            auto backend = find_if(begin(BACKENDS), end(BACKENDS), [&](const Backend& b) { return value == b.name; });
+            valid = backend != end(BACKENDS);
+            if (valid) {
+                SELECTED = {*backend};
+            }
+        } else if (option == "--comparar") {
+            SELECTED.assign(begin(BACKENDS), end(BACKENDS) - 1);  // Todas menos auto, que repite a otra
+            if (!format_given) {
+                FORMAT = Format::Tabla;
+            }
+        } else if (option.rfind("--insercion=", 0) == 0) {
+            auto name = find(begin(INSERTION_NAMES), end(INSERTION_NAMES), value);
+            valid = name != end(INSERTION_NAMES);
+            if (valid) {
+                INSERTION = static_cast<Insertion>(name - begin(INSERTION_NAMES));
+            }
+        } else if (option == "--formato=csv" || option == "--formato=json" || option == "--formato=tabla") {
+            FORMAT = value == "csv" ? Format::CSV : value == "json" ? Format::JSON : Format::Tabla;
+            format_given = true;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            cerr << "Opción no válida: " << option << "\n";
+            cerr << "Uso: " << argv[0] << " [--capacidades=<lista>] [--productores=<lista>] [--consumidores=<lista>]\n"
+                 << "       [--bytes=<lista de 8|64|256|1024|4096>] [--items=<N>] [--calentamiento=<R>] [--repeticiones=<R>]\n"
+                 << "       [--buffer=auto|semaforo|mutex|mpmc|spsc|carriles | --comparar] [--formato=csv|json|tabla]\n"
+                 << "       [--insercion=mover|construir|en-el-lugar]\n";
+            return 1;
+        }
+    }
+
+    logger.disable();  // Sin registro: se mide solo el buffer
+    if (FORMAT == Format::JSON) {
+        cout << "[\n";
+    } else if (FORMAT == Format::Tabla) {
+        printTableHeader();
+    } else {
+        cout << "buffer,insercion,bytes,capacidad,productores,consumidores,items_por_s,items_por_s_min,items_por_s_max,"
+                "latencia_p50_ns,latencia_p99_ns,latencia_p999_ns,latencia_max_ns\n";
+    }
+    bool first = true;
+    for (int bytes : PAYLOADS) {
+        for (int capacity : CAPACITIES) {
+            for (int producers : PRODUCERS) {
+                for (int consumers : CONSUMERS) {
+                    // Todas las implementaciones corren el mismo escenario una tras otra
+                    vector<optional<PointResult>> row;
+                    for (const Backend& backend : SELECTED) {
+                        if (backend.mode == BufferMode::SPSC && (producers != 1 || consumers != 1)) {
+                            row.emplace_back();  // El anillo SPSC solo admite un productor y un consumidor
+                            continue;
+                        }
+                        if (backend.mutex_queue && INSERTION == Insertion::EnElLugar) {
+                            row.emplace_back();  // La cola de referencia no tiene posiciones fijas donde escribir
+                            continue;
+                        }
+                        row.emplace_back(runPoint(backend, bytes, capacity, producers, consumers));
+                        if (FORMAT != Format::Tabla) {
+                            printResult(*row.back(), first);
+                            first = false;
+                        }
+                    }
+                    if (FORMAT == Format::Tabla && any_of(row.begin(), row.end(), [](const auto& r) { return r.has_value(); })) {
+                        printTableRow(row);
+                    }
+                }
+            }
+        }
+    }
+    if (FORMAT == Format::JSON) {
+        cout << "\n]\n";
+    }
+    return 0;
+}